@@ -27,6 +27,19 @@
  * ds_slab.h        - Slab Allocator
  * ds_signal.h      - Multicast Event
  * ds_optional.h    - Optional Value
+ * ds_pset.h        - Persistent Sorted Set
+ * ds_static_set.h  - Static Search Set
+ * ds_interval.h    - Interval Tree
+ * ds_hashset.h     - Unordered Hash Set
+ * ds_indexmap.h    - Insertion-Ordered Index Map
+ * ds_smallmap.h    - Small Inline Hash Map
+ * ds_phf.h         - Minimal Perfect Hash Function
+ * ds_lru.h         - Least Recently Used Cache
+ *
+ * ds_concurrent_map.h - Concurrent Sharded Hash Map
+ * ds_rcu_map.h        - Read-Copy-Update Hash Map
+ * ds_map_file.h       - Memory-Mapped Hash Map Files
+ * These headers are not included here since they require POSIX threads or mmap().
  */
 
 #ifndef DS_H
@@ -47,5 +60,13 @@
 #include "ds/ds_slab.h"
 #include "ds/ds_signal.h"
 #include "ds/ds_optional.h"
+#include "ds/ds_pset.h"
+#include "ds/ds_static_set.h"
+#include "ds/ds_interval.h"
+#include "ds/ds_hashset.h"
+#include "ds/ds_indexmap.h"
+#include "ds/ds_smallmap.h"
+#include "ds/ds_phf.h"
+#include "ds/ds_lru.h"
 
 #endif // DS_H
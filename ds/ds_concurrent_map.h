@@ -0,0 +1,514 @@
+// .h
+// ds.h Concurrent Sharded Hash Map Data Structure
+// by Kyle Furey
+
+/**
+ * ds_concurrent_map.h
+ *
+ * ds_DECLARE_CONCURRENT_MAP_NAMED(
+ *      name,           - The name of the data structure and function prefix.
+ *
+ *      K,              - The key type used to index V.
+ *
+ *      V,              - The value type to generate this data structure with.
+ *
+ *      key_hasher,     - Inline hashing code used to hash a key named <key>.
+ *                        You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                        ds_FAST_HASH and ds_FAST_STRING_HASH are faster for keys larger than a few bytes.
+ *
+ *      x_y_equals,     - Inline comparison code used to equate keys <x> and <y>.
+ *                        You can use ds_DEFAULT_EQUALS for trivial types.
+ *
+ *      value_deleter,  - The name of the function used to deallocate V.
+ *                        ds_void_deleter may be used for trivial types.
+ * )
+ *
+ * This is a hash map that many threads can read and write at once.
+ * Keys are split across ds_CONCURRENT_MAP_SHARDS shards by the high bits of their hash.
+ * Each shard is a ds_map.h map with its own lock, so threads only contend on the same shard.
+ *
+ * Writers lock their shard and mark it with a sequence number while it changes.
+ * Readers never lock. They copy a value out and retry if a writer changed the shard meanwhile.
+ * Buckets are written before their control byte is stored with release ordering, and readers load it with acquire
+ * ordering before comparing a key, so readers only compare keys that were fully written at some point.
+ *
+ * Skipped buckets are purged in place. Growing a shard builds a new table and publishes it.
+ * Readers count themselves in one of two phases of their shard. Before freeing the old table, the writer flips new
+ * readers onto the other phase and waits for the old one to drain, twice, so it only waits for reads already in progress.
+ * Each thread counts its reads in one of ds_CONCURRENT_MAP_READERS counters, picked by a hash of the thread.
+ * Counters sit on their own cache lines, away from the shard's sequence number and table, so reads do not contend.
+ *
+ * Values are copied out of the map, so V should be cheap to copy.
+ * Readers may compare keys that are being erased or overwritten, so any memory keys point to must outlive the map.
+ * Keys larger than a machine word may then be read half overwritten, so x_y_equals must be safe for such keys.
+ * The result of any such comparison is discarded when the reader retries.
+ *
+ * This header requires POSIX threads and GCC or Clang atomics, so ds.h does not include it.
+ *
+ * * Returns a new concurrent map with about <capacity> buckets split across its shards.
+ * * <capacity> must be greater than 0.
+ * * This data structure must be deleted with concurrent_map_delete().
+ *
+ *   concurrent_map   concurrent_map_new          ( size_t capacity )
+ *
+ * * Returns the number of elements in the map.
+ * * This is a snapshot and may be stale by the time it returns.
+ *
+ *   size_t           concurrent_map_count        ( const concurrent_map* self )
+ *
+ * * Copies the value that matches <key> into <value>.
+ * * Returns whether <key> was found. <value> is not changed if it was not.
+ *
+ *   bool             concurrent_map_find         ( const concurrent_map* self, K key, V* value )
+ *
+ * * Returns whether the map contains <key>.
+ *
+ *   bool             concurrent_map_contains     ( const concurrent_map* self, K key )
+ *
+ * * Inserts a new key-value pair into the map.
+ * * Returns whether a value was overwritten.
+ *
+ *   bool             concurrent_map_insert       ( concurrent_map* self, K key, V value )
+ *
+ * * Deletes the value that matches <key>.
+ * * Returns whether <key> was found.
+ *
+ *   bool             concurrent_map_erase        ( concurrent_map* self, K key )
+ *
+ * * Finds each of the <count> keys in <keys>, locking or validating each shard once.
+ * * Each found value is copied into <values> and each <found> is set to whether its key was found.
+ * * <found> may be NULL. Returns the number of keys found.
+ *
+ *   size_t           concurrent_map_find_batch   ( const concurrent_map* self, const K* keys, size_t count, V* values, bool* found )
+ *
+ * * Inserts each of the <count> pairs in <keys> and <values>, locking each shard once.
+ * * Returns the number of values overwritten.
+ *
+ *   size_t           concurrent_map_insert_batch ( concurrent_map* self, const K* keys, const V* values, size_t count )
+ *
+ * * Deletes each of the <count> keys in <keys>, locking each shard once.
+ * * Returns the number of keys found.
+ *
+ *   size_t           concurrent_map_erase_batch  ( concurrent_map* self, const K* keys, size_t count )
+ *
+ * * Deletes all pairs in the map.
+ *
+ *   void             concurrent_map_clear        ( concurrent_map* self )
+ *
+ * * Iterates the map calling <action> on each key and value.
+ * * Each shard is locked while it is visited, so <action> must not modify the map.
+ *
+ *   void             concurrent_map_foreach      ( const concurrent_map* self, void (*action)(K, V) )
+ *
+ * * Safely deletes a concurrent map.
+ * * No other thread may use the map while it is deleted.
+ *
+ *   void             concurrent_map_delete       ( concurrent_map* self )
+ */
+
+#ifndef DS_CONCURRENT_MAP_H
+#define DS_CONCURRENT_MAP_H
+
+#include <pthread.h>
+#include <sched.h>
+#include "ds_map.h"
+
+/** Declares a named concurrent sharded hash map of the given types. */
+#define ds_DECLARE_CONCURRENT_MAP_NAMED(name, K, V, key_hasher, x_y_equals, value_deleter)\
+\
+ds__DECLARE_ORDERED_MAP_NAMED(ds__##name##_map, K, V, key_hasher, x_y_equals, value_deleter)\
+\
+typedef struct {\
+    ds_size sequence;\
+    ds_size phase;\
+    ds__##name##_map *map;\
+    ds_byte read_padding[ds_CACHE_LINE];\
+    pthread_mutex_t lock;\
+    ds_size count;\
+    ds_byte write_padding[ds_CACHE_LINE];\
+} ds__##name##_shard;\
+\
+typedef struct {\
+    ds_size counts[ds_CONCURRENT_MAP_SHARDS][2];\
+    ds_byte padding[ds_CACHE_LINE];\
+} ds__##name##_readers;\
+\
+typedef struct {\
+    ds__##name##_shard *shards;\
+    ds__##name##_readers *readers;\
+} name;\
+\
+ds_API static inline ds_size ds__##name##_shard_index(ds_size hash) {\
+    return (hash >> (sizeof(ds_size) * 8 - 7 - ds_ctz(ds_CONCURRENT_MAP_SHARDS))) & (ds_CONCURRENT_MAP_SHARDS - 1);\
+}\
+\
+ds_API static inline void ds__##name##_write_begin(ds__##name##_shard *shard) {\
+    ds_assert(shard != ds_NULL);\
+    __atomic_store_n(&shard->sequence, shard->sequence + 1, __ATOMIC_RELAXED);\
+    __atomic_thread_fence(__ATOMIC_RELEASE);\
+}\
+\
+ds_API static inline void ds__##name##_write_end(ds__##name##_shard *shard) {\
+    ds_assert(shard != ds_NULL);\
+    __atomic_store_n(&shard->sequence, shard->sequence + 1, __ATOMIC_RELEASE);\
+}\
+\
+ds_API static inline ds_size ds__##name##_read_begin(ds__##name##_shard *shard) {\
+    ds_assert(shard != ds_NULL);\
+    ds_size sequence = __atomic_load_n(&shard->sequence, __ATOMIC_ACQUIRE);\
+    while (sequence & 1) {\
+        sequence = __atomic_load_n(&shard->sequence, __ATOMIC_ACQUIRE);\
+    }\
+    return sequence;\
+}\
+\
+ds_API static inline ds_bool ds__##name##_read_retry(ds__##name##_shard *shard, ds_size sequence) {\
+    ds_assert(shard != ds_NULL);\
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);\
+    return __atomic_load_n(&shard->sequence, __ATOMIC_RELAXED) != sequence;\
+}\
+\
+ds_API static inline void ds__##name##_release(ds__##name##_map *map) {\
+    ds_assert(map != ds_NULL);\
+    if (map->old_controls != ds_NULL) {\
+        ds_free(map->old_controls);\
+        ds__ds__##name##_map_vector_delete(&map->old_buckets);\
+    }\
+    ds_free(map->controls);\
+    ds__ds__##name##_map_vector_delete(&map->buckets);\
+    ds_free(map);\
+}\
+\
+ds_API static inline ds_size ds__##name##_reader(void) {\
+    pthread_t thread = pthread_self();\
+    return ds_hash_mix(ds_hashify(sizeof(thread), &thread)) % ds_CONCURRENT_MAP_READERS;\
+}\
+\
+ds_API static inline ds_size ds__##name##_enter(const name *self, ds_size reader, ds_size index) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(reader < ds_CONCURRENT_MAP_READERS);\
+    ds_assert(index < ds_CONCURRENT_MAP_SHARDS);\
+    ds_size phase = __atomic_load_n(&self->shards[index].phase, __ATOMIC_SEQ_CST) & 1;\
+    __atomic_fetch_add(&self->readers[reader].counts[index][phase], 1, __ATOMIC_SEQ_CST);\
+    return phase;\
+}\
+\
+ds_API static inline void ds__##name##_leave(const name *self, ds_size reader, ds_size index, ds_size phase) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(reader < ds_CONCURRENT_MAP_READERS);\
+    ds_assert(index < ds_CONCURRENT_MAP_SHARDS);\
+    __atomic_fetch_sub(&self->readers[reader].counts[index][phase], 1, __ATOMIC_RELEASE);\
+}\
+\
+ds_API static inline void ds__##name##_synchronize(name *self, ds_size index) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(index < ds_CONCURRENT_MAP_SHARDS);\
+    ds__##name##_shard *shard = self->shards + index;\
+    for (ds_size flips = 0; flips < 2; ++flips) {\
+        ds_size phase = shard->phase & 1;\
+        __atomic_store_n(&shard->phase, shard->phase + 1, __ATOMIC_SEQ_CST);\
+        for (ds_size reader = 0; reader < ds_CONCURRENT_MAP_READERS; ++reader) {\
+            while (__atomic_load_n(&self->readers[reader].counts[index][phase], __ATOMIC_SEQ_CST) != 0) {\
+                sched_yield();\
+            }\
+        }\
+    }\
+}\
+\
+ds_API static inline void ds__##name##_reserve(name *self, ds_size index) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(index < ds_CONCURRENT_MAP_SHARDS);\
+    ds__##name##_shard *shard = self->shards + index;\
+    ds__##name##_map *map = shard->map;\
+    ds_size capacity = map->buckets.capacity;\
+    if (ds_MAP_LOAD_FACTOR_DEN * (map->count + map->skips + 1) <= ds_MAP_LOAD_FACTOR_NUM * capacity) {\
+        return;\
+    }\
+    if (2 * ds_MAP_LOAD_FACTOR_DEN * (map->count + 1) <= ds_MAP_LOAD_FACTOR_NUM * capacity) {\
+        ds__##name##_write_begin(shard);\
+        ds__##name##_map_purge(map);\
+        ds__##name##_write_end(shard);\
+        return;\
+    }\
+    ds__##name##_map *grown = (ds__##name##_map *) ds_malloc(sizeof(ds__##name##_map));\
+    ds_assert(grown != ds_NULL);\
+    *grown = ds__##name##_map_new(capacity * ds_VECTOR_EXPANSION);\
+    ds__##name##_map_iter iter = ds__##name##_map_iter_begin(map);\
+    const K *key;\
+    V *value;\
+    while (ds__##name##_map_iter_next(&iter, &key, &value)) {\
+        ds__##name##_map_insert(grown, *key, *value);\
+    }\
+    __atomic_store_n(&shard->map, grown, __ATOMIC_SEQ_CST);\
+    ds__##name##_synchronize(self, index);\
+    ds__##name##_release(map);\
+}\
+\
+ds_API static inline ds_bool ds__##name##_insert(name *self, ds_size index, K key, V value) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(index < ds_CONCURRENT_MAP_SHARDS);\
+    ds__##name##_shard *shard = self->shards + index;\
+    ds__##name##_reserve(self, index);\
+    ds__##name##_write_begin(shard);\
+    ds_bool overwritten = ds__##name##_map_insert(shard->map, key, value);\
+    ds__##name##_write_end(shard);\
+    if (!overwritten) {\
+        __atomic_store_n(&shard->count, shard->count + 1, __ATOMIC_RELAXED);\
+    }\
+    return overwritten;\
+}\
+\
+ds_API static inline ds_bool ds__##name##_erase(ds__##name##_shard *shard, K key) {\
+    ds_assert(shard != ds_NULL);\
+    ds__##name##_write_begin(shard);\
+    ds_bool erased = ds__ds__##name##_map_remove(shard->map, key);\
+    ds__##name##_write_end(shard);\
+    if (erased) {\
+        __atomic_store_n(&shard->count, shard->count - 1, __ATOMIC_RELAXED);\
+    }\
+    return erased;\
+}\
+\
+ds_API static inline ds_size *ds__##name##_order(const K *keys, ds_size count) {\
+    ds_assert(keys != ds_NULL);\
+    ds_size *order = (ds_size *) ds_malloc(sizeof(ds_size) * (count * 2 + ds_CONCURRENT_MAP_SHARDS + 1));\
+    ds_assert(order != ds_NULL);\
+    ds_size *shards = order + count;\
+    ds_size *starts = shards + count;\
+    ds_memset(starts, 0, sizeof(ds_size) * (ds_CONCURRENT_MAP_SHARDS + 1));\
+    for (ds_size i = 0; i < count; ++i) {\
+        shards[i] = ds__##name##_shard_index(ds__##name##_map_hash(keys[i]));\
+        ++starts[shards[i] + 1];\
+    }\
+    for (ds_size i = 0; i < ds_CONCURRENT_MAP_SHARDS; ++i) {\
+        starts[i + 1] += starts[i];\
+    }\
+    for (ds_size i = 0; i < count; ++i) {\
+        order[starts[shards[i]]++] = i;\
+    }\
+    for (ds_size i = 0; i < count; ++i) {\
+        shards[i] = ds__##name##_shard_index(ds__##name##_map_hash(keys[order[i]]));\
+    }\
+    return order;\
+}\
+\
+ds_API static inline name name##_new(ds_size capacity) {\
+    ds_assert(capacity > 0);\
+    ds_assert((ds_CONCURRENT_MAP_SHARDS & (ds_CONCURRENT_MAP_SHARDS - 1)) == 0);\
+    name self = (name) {\
+        (ds__##name##_shard *) ds_calloc(ds_CONCURRENT_MAP_SHARDS, sizeof(ds__##name##_shard)),\
+        (ds__##name##_readers *) ds_calloc(ds_CONCURRENT_MAP_READERS, sizeof(ds__##name##_readers)),\
+    };\
+    ds_assert(self.shards != ds_NULL);\
+    ds_assert(self.readers != ds_NULL);\
+    ds_size shard_capacity = capacity / ds_CONCURRENT_MAP_SHARDS + 1;\
+    for (ds_size i = 0; i < ds_CONCURRENT_MAP_SHARDS; ++i) {\
+        ds__##name##_shard *shard = self.shards + i;\
+        int result = pthread_mutex_init(&shard->lock, ds_NULL);\
+        ds_assert(result == 0);\
+        (void) result;\
+        shard->map = (ds__##name##_map *) ds_malloc(sizeof(ds__##name##_map));\
+        ds_assert(shard->map != ds_NULL);\
+        *shard->map = ds__##name##_map_new(shard_capacity);\
+    }\
+    return self;\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds_size count = 0;\
+    for (ds_size i = 0; i < ds_CONCURRENT_MAP_SHARDS; ++i) {\
+        count += __atomic_load_n(&self->shards[i].count, __ATOMIC_RELAXED);\
+    }\
+    return count;\
+}\
+\
+ds_API static inline ds_bool name##_find(const name *self, K key, V *value) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds_size hash = ds__##name##_map_hash(key);\
+    ds_size index = ds__##name##_shard_index(hash);\
+    ds__##name##_shard *shard = self->shards + index;\
+    ds_size reader = ds__##name##_reader();\
+    ds_size phase = ds__##name##_enter(self, reader, index);\
+    ds_bool found = ds_false;\
+    V copy = {0};\
+    ds_size sequence;\
+    do {\
+        sequence = ds__##name##_read_begin(shard);\
+        const ds__##name##_map *map = __atomic_load_n(&shard->map, __ATOMIC_SEQ_CST);\
+        const ds__ds__##name##_map_bucket *bucket = ds__ds__##name##_map_lookup(map, key, hash);\
+        found = bucket != ds_NULL;\
+        if (found) {\
+            copy = bucket->value;\
+        }\
+    } while (ds__##name##_read_retry(shard, sequence));\
+    ds__##name##_leave(self, reader, index, phase);\
+    if (found && value != ds_NULL) {\
+        *value = copy;\
+    }\
+    return found;\
+}\
+\
+ds_API static inline ds_bool name##_contains(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    return name##_find(self, key, ds_NULL);\
+}\
+\
+ds_API static inline ds_bool name##_insert(name *self, K key, V value) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds_size index = ds__##name##_shard_index(ds__##name##_map_hash(key));\
+    ds__##name##_shard *shard = self->shards + index;\
+    pthread_mutex_lock(&shard->lock);\
+    ds_bool overwritten = ds__##name##_insert(self, index, key, value);\
+    pthread_mutex_unlock(&shard->lock);\
+    return overwritten;\
+}\
+\
+ds_API static inline ds_bool name##_erase(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds__##name##_shard *shard = self->shards + ds__##name##_shard_index(ds__##name##_map_hash(key));\
+    pthread_mutex_lock(&shard->lock);\
+    ds_bool erased = ds__##name##_erase(shard, key);\
+    pthread_mutex_unlock(&shard->lock);\
+    return erased;\
+}\
+\
+ds_API static inline ds_size name##_find_batch(const name *self, const K *keys, ds_size count, V *values, ds_bool *found) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds_assert(count == 0 || (keys != ds_NULL && values != ds_NULL));\
+    if (count == 0) {\
+        return 0;\
+    }\
+    ds_size *order = ds__##name##_order(keys, count);\
+    const ds_size *shards = order + count;\
+    ds_size reader = ds__##name##_reader();\
+    ds_size total = 0;\
+    for (ds_size start = 0, end = 0; start < count; start = end) {\
+        ds__##name##_shard *shard = self->shards + shards[start];\
+        for (end = start + 1; end < count && shards[end] == shards[start]; ++end) {\
+        }\
+        ds_size phase = ds__##name##_enter(self, reader, shards[start]);\
+        ds_size matches;\
+        ds_size sequence;\
+        do {\
+            matches = 0;\
+            sequence = ds__##name##_read_begin(shard);\
+            const ds__##name##_map *map = __atomic_load_n(&shard->map, __ATOMIC_SEQ_CST);\
+            for (ds_size i = start; i < end; ++i) {\
+                ds_size index = order[i];\
+                const ds__ds__##name##_map_bucket *bucket =\
+                        ds__ds__##name##_map_lookup(map, keys[index], ds__##name##_map_hash(keys[index]));\
+                if (found != ds_NULL) {\
+                    found[index] = bucket != ds_NULL;\
+                }\
+                if (bucket != ds_NULL) {\
+                    values[index] = bucket->value;\
+                    ++matches;\
+                }\
+            }\
+        } while (ds__##name##_read_retry(shard, sequence));\
+        ds__##name##_leave(self, reader, shards[start], phase);\
+        total += matches;\
+    }\
+    ds_free(order);\
+    return total;\
+}\
+\
+ds_API static inline ds_size name##_insert_batch(name *self, const K *keys, const V *values, ds_size count) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds_assert(count == 0 || (keys != ds_NULL && values != ds_NULL));\
+    if (count == 0) {\
+        return 0;\
+    }\
+    ds_size *order = ds__##name##_order(keys, count);\
+    const ds_size *shards = order + count;\
+    ds_size overwritten = 0;\
+    for (ds_size start = 0, end = 0; start < count; start = end) {\
+        ds__##name##_shard *shard = self->shards + shards[start];\
+        pthread_mutex_lock(&shard->lock);\
+        for (end = start; end < count && shards[end] == shards[start]; ++end) {\
+            overwritten += ds__##name##_insert(self, shards[start], keys[order[end]], values[order[end]]);\
+        }\
+        pthread_mutex_unlock(&shard->lock);\
+    }\
+    ds_free(order);\
+    return overwritten;\
+}\
+\
+ds_API static inline ds_size name##_erase_batch(name *self, const K *keys, ds_size count) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds_assert(count == 0 || keys != ds_NULL);\
+    if (count == 0) {\
+        return 0;\
+    }\
+    ds_size *order = ds__##name##_order(keys, count);\
+    const ds_size *shards = order + count;\
+    ds_size erased = 0;\
+    for (ds_size start = 0, end = 0; start < count; start = end) {\
+        ds__##name##_shard *shard = self->shards + shards[start];\
+        pthread_mutex_lock(&shard->lock);\
+        for (end = start; end < count && shards[end] == shards[start]; ++end) {\
+            erased += ds__##name##_erase(shard, keys[order[end]]);\
+        }\
+        pthread_mutex_unlock(&shard->lock);\
+    }\
+    ds_free(order);\
+    return erased;\
+}\
+\
+ds_API static inline void name##_clear(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    for (ds_size i = 0; i < ds_CONCURRENT_MAP_SHARDS; ++i) {\
+        ds__##name##_shard *shard = self->shards + i;\
+        pthread_mutex_lock(&shard->lock);\
+        ds__##name##_write_begin(shard);\
+        ds__##name##_map_clear(shard->map);\
+        ds__##name##_write_end(shard);\
+        __atomic_store_n(&shard->count, 0, __ATOMIC_RELAXED);\
+        pthread_mutex_unlock(&shard->lock);\
+    }\
+}\
+\
+ds_API static inline void name##_foreach(const name *self, void(*action)(K, V)) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds_assert(action != ds_NULL);\
+    for (ds_size i = 0; i < ds_CONCURRENT_MAP_SHARDS; ++i) {\
+        ds__##name##_shard *shard = self->shards + i;\
+        pthread_mutex_lock(&shard->lock);\
+        ds__##name##_map_foreach(shard->map, action);\
+        pthread_mutex_unlock(&shard->lock);\
+    }\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->shards != ds_NULL);\
+    ds_assert(self->readers != ds_NULL);\
+    for (ds_size i = 0; i < ds_CONCURRENT_MAP_SHARDS; ++i) {\
+        ds__##name##_shard *shard = self->shards + i;\
+        for (ds_size reader = 0; reader < ds_CONCURRENT_MAP_READERS; ++reader) {\
+            ds_assert(self->readers[reader].counts[i][0] == 0 && self->readers[reader].counts[i][1] == 0);\
+        }\
+        ds__##name##_map_delete(shard->map);\
+        ds_free(shard->map);\
+        pthread_mutex_destroy(&shard->lock);\
+    }\
+    ds_free(self->shards);\
+    ds_free(self->readers);\
+    *self = (name) {0};\
+}
+
+/** Declares a concurrent sharded hash map of the given types. */
+#define ds_DECLARE_CONCURRENT_MAP(K, V, key_hasher, x_y_equals, value_deleter)\
+        ds_DECLARE_CONCURRENT_MAP_NAMED(K##_##V##_concurrent_map, K, V, key_hasher, x_y_equals, value_deleter)
+
+#endif // DS_CONCURRENT_MAP_H
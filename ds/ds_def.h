@@ -9,8 +9,14 @@
  * Settings, default parameters, and repeated functionality are defined here.
  *
  * ds_malloc, ds_calloc, ds_realloc, and ds_free are ds.h's default allocator functions.
- * ds_memcpy, ds_memmove, ds_memset are ds.h's default memory functions.
- * ds_strlen, ds_tolower, ds_toupper, ds_isspace are ds.h's default string functions.
+ * ds_memcpy, ds_memmove, ds_memset, ds_memcmp are ds.h's default memory functions.
+ * ds_strlen, ds_strcmp, ds_strncmp, ds_tolower, ds_toupper, ds_isspace are ds.h's default string functions.
+ *
+ * ds_prefetch() hints that memory will be read soon. It is a no-op without compiler support.
+ * ds_store_release() and ds_load_acquire() order a byte against the memory written before it, for lock-free readers.
+ * They are plain stores and loads without compiler support.
+ *
+ * ds_CACHE_LINE is the assumed size of a cache line in bytes.
  *
  * ds_ARENA_ALIGN is a macro used to align an arena's memory.
  * ds_ARENA_LEAK_ASSERT is whether arena_delete() will assert if memory is "leaked".
@@ -20,15 +26,38 @@
  *
  * ds_MAP_LOAD_FACTOR_NUM / ds_MAP_LOAD_FACTOR_DEN is the maximum percentage a map can be filled.
  * When the map's capacity is greater than this fraction, it will rehash its values.
+ * ds_MAP_SHRINK_FACTOR_NUM / ds_MAP_SHRINK_FACTOR_DEN is the minimum percentage a map can be filled before erasing shrinks it.
+ * It is 0 by default, so erasing never shrinks a map or moves its pairs.
+ * ds_MAP_GROUP is the number of control bytes a map probes at once. It is also a map's minimum capacity.
+ * It is fixed at 16 to match one SSE2 register and the 16-bit group masks, so it must not be changed.
+ * ds_MAP_POW2 is whether maps round their capacity up to a power of two and index buckets with a mask.
+ * ds_MAP_INCREMENTAL_REHASH is whether maps move buckets to a new table a few at a time when rehashing.
+ * ds_MAP_REHASH_STEP is the number of buckets moved by each insert or find during an incremental rehash.
+ * ds_MAP_STATS_PROBES is the number of probe lengths map_stats() counts separately.
+ * ds_MAP_COUNT_PROBES is whether maps count each lookup and the groups it probes for map_probes(). It is for debugging.
+ * ds_CONCURRENT_MAP_SHARDS is the number of separately locked maps in a concurrent map. It must be a power of two.
+ * ds_CONCURRENT_MAP_READERS is the number of cache-line-padded reader counters in a concurrent map.
+ * Reading threads are spread across them by a hash of their thread, so threads rarely share one.
+ * ds_PHF_BUCKET_SIZE is the average number of keys that share a pilot in a perfect hash function.
  *
  * ds_DEFAULT_COMPARE can replace x_y_comparer for trivial numeric comparisons.
  * ds_REVERSE_COMPARE is the exact opposite of ds_DEFAULT_COMPARE.
  *
+ * ds_DEFAULT_COMPARE3 can replace x_y_compare for trivial numeric three-way comparisons.
+ * ds_REVERSE_COMPARE3 is the exact opposite of ds_DEFAULT_COMPARE3.
+ * ds_STRING_COMPARE3 calls strcmp() on two strings. Replaces x_y_compare.
+ *
  * ds_DEFAULT_EQUALS can replace x_y_equals for trivial numeric equality.
  *
  * ds_DEFAULT_HASH calls ds_hashify() on any key to get its hash number. Replaces key_hasher.
  * ds_INT_HASH uses an integer type as a hash number. Replaces key_hasher.
  * ds_STRING_HASH calls ds_hashify() on a string with strlen(). Replaces key_hasher.
+ * ds_FAST_HASH calls ds_fast_hashify() on any key to get its hash number. Replaces key_hasher.
+ * ds_FAST_STRING_HASH calls ds_fast_hashify() on a string with strlen(). Replaces key_hasher.
+ *
+ * ds_BYTES_HASH calls ds_hashify() on <size> bytes at <data>. It matches ds_STRING_HASH. Replaces bytes_hasher.
+ * ds_FAST_BYTES_HASH calls ds_fast_hashify() on <size> bytes at <data>. It matches ds_FAST_STRING_HASH. Replaces bytes_hasher.
+ * ds_BYTES_EQUALS equates a string <key> with <size> bytes at <data>. Bytes with a null character never match. Replaces key_bytes_equals.
  *
  * ds_NULL is a sentinel value used to indicate an invalid pointer.
  * ds_NOT_FOUND is a sentinel value used to indicate an invalid index.
@@ -40,15 +69,28 @@
  *
  * ds_false and ds_true are boolean values used internally.
  *
- * ds_BUCKET_EMPTY indicates a bucket is empty.
- * ds_BUCKET_OCCUPIED indicates a bucket is full.
- * ds_BUCKET_SKIP indicates a bucket was once full.
+ * ds_BUCKET_EMPTY is the control byte of an empty bucket.
+ * ds_BUCKET_OCCUPIED masks the 7 hash bits stored as the control byte of a full bucket.
+ * ds_BUCKET_SKIP is the control byte of a bucket that was once full and may have been probed past.
  *
  * ds_bool, ds_byte, ds_int, ds_uint, ds_size, and ds_diff are type aliases used internally.
  *
  * ds_void_deleter() is a no-op deleter function used for data structures with trivial types.
  *
+ * ds_ctz() counts the trailing zero bits of a non-zero number.
+ * ds_clz() counts the leading zero bits of a non-zero number.
+ *
  * ds_hashify() is a generic Fowler-Noll-Vo implementation for hashing keys.
+ * ds_fast_hashify() is a wyhash-style hash that reads 8 or 16 bytes per step. It is much faster for large keys.
+ * ds_fast_hashify_seeded() is ds_fast_hashify() with a custom seed.
+ * ds_hash_mix() spreads every bit of a hash across its low and high bits before a map uses it.
+ *
+ * ds_map_control() returns the control byte stored in a full map bucket for a hash.
+ * ds_group_match(), ds_group_empty(), and ds_group_free() find control bytes in a map group.
+ * These use SSE2 when it is available to match every byte in a group at once.
+ *
+ * ds_DECLARE_SORT_NAMED() declares a stable merge sort used by sorted data structures.
+ * ds__DECLARE_INDEX_TABLE() declares the linear probing table of entry indices shared by index maps and LRU caches.
  */
 
 #ifndef DS_DEF_H
@@ -66,13 +108,35 @@
 #define ds_memcpy   memcpy
 #define ds_memmove  memmove
 #define ds_memset   memset
+#define ds_memcmp   memcmp
 
 /** The default data structure string functions. */
 #define ds_strlen   strlen
+#define ds_strcmp   strcmp
+#define ds_strncmp  strncmp
 #define ds_tolower  tolower
 #define ds_toupper  toupper
 #define ds_isspace  isspace
 
+/** Hints that memory will be read soon. */
+#if defined(__GNUC__) || defined(__clang__)
+#define ds_prefetch(ptr) __builtin_prefetch(ptr)
+#else
+#define ds_prefetch(ptr) ((void) (ptr))
+#endif
+
+/** Stores and loads a byte with release and acquire ordering, so lock-free readers see what was written before it. */
+#if defined(__GNUC__) || defined(__clang__)
+#define ds_store_release(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#define ds_load_acquire(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#else
+#define ds_store_release(ptr, value) ((void) (*(ptr) = (value)))
+#define ds_load_acquire(ptr) (*(ptr))
+#endif
+
+/** The assumed size of a cache line. */
+#define ds_CACHE_LINE 64
+
 /** Aligns a size for an arena. */
 #define ds_ARENA_ALIGN(size, alignment) (((size) + ((alignment) - 1)) & ~((alignment) - 1))
 
@@ -89,13 +153,51 @@
 #define ds_MAP_LOAD_FACTOR_NUM 1
 #define ds_MAP_LOAD_FACTOR_DEN 2
 
+/** The minimum fill capacity before erasing shrinks a map. */
+#define ds_MAP_SHRINK_FACTOR_NUM 0
+#define ds_MAP_SHRINK_FACTOR_DEN 8
+
+/** The number of map control bytes probed at once. This must be 16. */
+#define ds_MAP_GROUP 16
+#if ds_MAP_GROUP != 16
+#error "ds_MAP_GROUP must be 16 to match the SSE2 and bit mask group probing!"
+#endif
+
+/** Whether to round map capacities to a power of two to index without dividing. */
+#define ds_MAP_POW2 1
+
+/** Whether maps rehash incrementally, and how many buckets to move per operation. */
+#define ds_MAP_INCREMENTAL_REHASH 0
+#define ds_MAP_REHASH_STEP 64
+
+/** The number of probe lengths in a map's statistics, and whether maps count their probes. */
+#define ds_MAP_STATS_PROBES 16
+#define ds_MAP_COUNT_PROBES 0
+
+/** The number of separately locked shards in a concurrent map. */
+#define ds_CONCURRENT_MAP_SHARDS 32
+
+/** The number of reader counters in a concurrent map, each on its own cache lines. */
+#define ds_CONCURRENT_MAP_READERS 64
+
+/** The average number of keys per bucket of a perfect hash function. */
+#define ds_PHF_BUCKET_SIZE 4
+
 /** Data structure parameters for trivial types. */
 #define ds_DEFAULT_COMPARE x > y
 #define ds_REVERSE_COMPARE x <= y
+#define ds_DEFAULT_COMPARE3 (x > y) - (x < y)
+#define ds_REVERSE_COMPARE3 (x < y) - (x > y)
+#define ds_STRING_COMPARE3 ds_strcmp(x, y)
 #define ds_DEFAULT_EQUALS  x == y
 #define ds_DEFAULT_HASH    ds_hashify(sizeof(key), &key)
 #define ds_INT_HASH        key
 #define ds_STRING_HASH     ds_hashify(ds_strlen(key), key)
+#define ds_FAST_HASH       ds_fast_hashify(sizeof(key), &key)
+#define ds_FAST_STRING_HASH ds_fast_hashify(ds_strlen(key), key)
+#define ds_BYTES_HASH      ds_hashify(size, data)
+#define ds_FAST_BYTES_HASH ds_fast_hashify(size, data)
+#define ds_BYTES_EQUALS    (ds_strlen(key) == size && (size == 0 || ds_memcmp(key, data, size) == 0))
 
 /** A value of a pointer with no data. */
 #define ds_NULL NULL
@@ -125,11 +227,11 @@ enum {
     ds_true = 1,
 };
 
-/** Each state in a hash map bucket. */
+/** Each state in a hash map bucket's control byte. */
 enum {
-    ds_BUCKET_EMPTY = 0,
-    ds_BUCKET_OCCUPIED = 1,
-    ds_BUCKET_SKIP = 2,
+    ds_BUCKET_EMPTY = 0x80,
+    ds_BUCKET_OCCUPIED = 0x7F,
+    ds_BUCKET_SKIP = 0xFE,
 };
 
 /** OS-aligned types for data structures. */
@@ -145,9 +247,39 @@ ds_API static inline void ds_void_deleter(void *self) {
     (void) self;
 }
 
+/** Counts the trailing zero bits of a non-zero number. */
+ds_API static inline ds_uint ds_ctz(ds_size value) {
+    ds_assert(value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return (ds_uint) __builtin_ctzll((unsigned long long) value);
+#else
+    ds_uint count = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/** Counts the leading zero bits of a non-zero number. */
+ds_API static inline ds_uint ds_clz(ds_size value) {
+    ds_assert(value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return (ds_uint) __builtin_clzll((unsigned long long) value) - (ds_uint) (sizeof(unsigned long long) - sizeof(ds_size)) * 8;
+#else
+    ds_uint count = 0;
+    while ((value & ((ds_size) 1 << (sizeof(ds_size) * 8 - 1))) == 0) {
+        value <<= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
 /** Hashes any data as an array of bytes. */
 ds_API static inline ds_size ds_hashify(ds_size size, const void *data) {
-    ds_assert(data != ds_NULL);
+    ds_assert(size == 0 || data != ds_NULL);
     // FNV-1a
     const ds_byte *memory = (ds_byte *) data;
     ds_size hash = 2166136261u; // FNV offset
@@ -158,4 +290,256 @@ ds_API static inline ds_size ds_hashify(ds_size size, const void *data) {
     return hash;
 }
 
+/** Multiplies two 64-bit numbers and folds the 128-bit product into 64 bits. */
+ds_API static inline uint64_t ds__fast_mix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 product = (unsigned __int128) a * b;
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+#else
+    uint64_t a_high = a >> 32, a_low = (uint32_t) a;
+    uint64_t b_high = b >> 32, b_low = (uint32_t) b;
+    uint64_t middle_a = a_high * b_low, middle_b = b_high * a_low;
+    uint64_t low = a_low * b_low;
+    uint64_t sum = low + (middle_a << 32);
+    uint64_t carry = sum < low;
+    uint64_t product_low = sum + (middle_b << 32);
+    carry += product_low < sum;
+    uint64_t product_high = a_high * b_high + (middle_a >> 32) + (middle_b >> 32) + carry;
+    return product_low ^ product_high;
+#endif
+}
+
+/** Reads up to 8 unaligned bytes as a number. */
+ds_API static inline uint64_t ds__fast_read(const ds_byte *data, ds_size size) {
+    ds_assert(size <= sizeof(uint64_t));
+    if (size == sizeof(uint64_t)) {
+        uint64_t value;
+        ds_memcpy(&value, data, sizeof(uint64_t));
+        return value;
+    }
+    uint32_t value;
+    ds_memcpy(&value, data, sizeof(uint32_t));
+    return value;
+}
+
+/** Hashes any data as an array of bytes with a seed, 16 bytes at a time. */
+ds_API static inline ds_size ds_fast_hashify_seeded(ds_size size, const void *data, uint64_t seed) {
+    ds_assert(size == 0 || data != ds_NULL);
+    // wyhash
+    static const uint64_t secret[4] = {
+        0xA0761D6478BD642Full,
+        0xE7037ED1A0B428DBull,
+        0x8EBC6AF09C88C6DBull,
+        0x589965CC75374CC3ull,
+    };
+    const ds_byte *memory = (const ds_byte *) data;
+    seed ^= ds__fast_mix(seed ^ secret[0], secret[1]);
+    uint64_t a, b;
+    if (size == sizeof(uint64_t)) {
+        a = ds__fast_read(memory, 8);
+        b = a >> 32 | a << 32;
+    } else if (size == sizeof(uint32_t)) {
+        a = ds__fast_read(memory, 4);
+        b = a;
+    } else if (size <= 16) {
+        if (size >= 4) {
+            ds_size offset = (size >> 3) << 2;
+            a = ds__fast_read(memory, 4) << 32 | ds__fast_read(memory + offset, 4);
+            b = ds__fast_read(memory + size - 4, 4) << 32 | ds__fast_read(memory + size - 4 - offset, 4);
+        } else if (size > 0) {
+            a = (uint64_t) memory[0] << 16 | (uint64_t) memory[size >> 1] << 8 | memory[size - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        ds_size remaining = size;
+        if (remaining > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = ds__fast_mix(ds__fast_read(memory, 8) ^ secret[1], ds__fast_read(memory + 8, 8) ^ seed);
+                seed1 = ds__fast_mix(ds__fast_read(memory + 16, 8) ^ secret[2], ds__fast_read(memory + 24, 8) ^ seed1);
+                seed2 = ds__fast_mix(ds__fast_read(memory + 32, 8) ^ secret[3], ds__fast_read(memory + 40, 8) ^ seed2);
+                memory += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (remaining > 16) {
+            seed = ds__fast_mix(ds__fast_read(memory, 8) ^ secret[1], ds__fast_read(memory + 8, 8) ^ seed);
+            memory += 16;
+            remaining -= 16;
+        }
+        a = ds__fast_read(memory + remaining - 16, 8);
+        b = ds__fast_read(memory + remaining - 8, 8);
+    }
+    return (ds_size) ds__fast_mix(ds__fast_mix(a ^ secret[1], b ^ seed) ^ secret[0] ^ size, secret[1]);
+}
+
+/** Hashes any data as an array of bytes, 16 bytes at a time. */
+ds_API static inline ds_size ds_fast_hashify(ds_size size, const void *data) {
+    return ds_fast_hashify_seeded(size, data, 0);
+}
+
+/** Mixes a hash so nearby keys land far apart in a map. */
+ds_API static inline ds_size ds_hash_mix(ds_size hash) {
+    // Fibonacci hashing, folding the high bits back into the low bits
+#if ds_SIZE_MAX > 0xFFFFFFFFu
+    hash ^= hash >> 32;
+    hash *= (ds_size) 0x9E3779B97F4A7C15ull; // 2^64 / golden ratio
+    hash ^= hash >> 32;
+#else
+    hash ^= hash >> 16;
+    hash *= (ds_size) 0x9E3779B9u; // 2^32 / golden ratio
+    hash ^= hash >> 16;
+#endif
+    return hash;
+}
+
+/** Returns the control byte of a full map bucket with the given mixed hash. */
+ds_API static inline ds_byte ds_map_control(ds_size hash) {
+    return (ds_byte) ((hash >> (sizeof(ds_size) * 8 - 7)) & ds_BUCKET_OCCUPIED);
+}
+
+/** Returns a bit mask of each control byte in a map group equal to <control>. */
+ds_API static inline ds_uint ds_group_match(const ds_byte *group, ds_byte control) {
+    ds_assert(group != ds_NULL);
+#if ds_SSE2
+    __m128i controls = _mm_loadu_si128((const __m128i *) group);
+    return (ds_uint) _mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8((char) control)));
+#else
+    ds_uint mask = 0;
+    for (ds_uint i = 0; i < ds_MAP_GROUP; ++i) {
+        mask |= (ds_uint) (group[i] == control) << i;
+    }
+    return mask;
+#endif
+}
+
+/** Returns a bit mask of each empty control byte in a map group. */
+ds_API static inline ds_uint ds_group_empty(const ds_byte *group) {
+    return ds_group_match(group, ds_BUCKET_EMPTY);
+}
+
+/** Returns a bit mask of each empty or skipped control byte in a map group. */
+ds_API static inline ds_uint ds_group_free(const ds_byte *group) {
+    ds_assert(group != ds_NULL);
+#if ds_SSE2
+    return (ds_uint) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) group));
+#else
+    ds_uint mask = 0;
+    for (ds_uint i = 0; i < ds_MAP_GROUP; ++i) {
+        mask |= (ds_uint) (group[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+/** Declares a named stable merge sort of the given type. <buffer> must hold <count> elements. */
+#define ds_DECLARE_SORT_NAMED(name, T, x_y_comparer)\
+\
+ds_API static inline void name(T *array, T *buffer, ds_size count) {\
+    ds_assert(count == 0 || (array != ds_NULL && buffer != ds_NULL));\
+    T *source = array;\
+    T *target = buffer;\
+    for (ds_size width = 1; width < count; width *= 2) {\
+        for (ds_size start = 0; start < count; start += 2 * width) {\
+            ds_size middle = start + width < count ? start + width : count;\
+            ds_size end = middle + width < count ? middle + width : count;\
+            ds_size left = start;\
+            ds_size right = middle;\
+            ds_size index = start;\
+            while (left < middle && right < end) {\
+                T x = source[left];\
+                T y = source[right];\
+                if ((x_y_comparer)) {\
+                    target[index++] = source[right++];\
+                } else {\
+                    target[index++] = source[left++];\
+                }\
+            }\
+            while (left < middle) {\
+                target[index++] = source[left++];\
+            }\
+            while (right < end) {\
+                target[index++] = source[right++];\
+            }\
+        }\
+        T *swap = source;\
+        source = target;\
+        target = swap;\
+    }\
+    if (source != array) {\
+        ds_memcpy(array, source, sizeof(T) * count);\
+    }\
+}
+
+/**
+ * Declares a named linear probing table of <I> indices into an array of entries <E> with <key> and <hash> fields.
+ * Empty slots hold (I) -1. Removing a slot shifts later indices back, so the table never fills with skipped slots.
+ */
+#define ds__DECLARE_INDEX_TABLE(name, K, E, I, x_y_equals)\
+\
+ds_API static inline ds_size ds__##name##_slots(ds_size count) {\
+    ds_size slots = 8;\
+    while (ds_MAP_LOAD_FACTOR_DEN * count > ds_MAP_LOAD_FACTOR_NUM * slots) {\
+        ds_assert(slots <= ds_SIZE_MAX / 2);\
+        slots *= 2;\
+    }\
+    return slots;\
+}\
+\
+ds_API static inline ds_size ds__##name##_probe(const I *indices, ds_size mask, const E *entries, K key, I hash) {\
+    ds_assert(indices != ds_NULL);\
+    for (ds_size position = hash & mask;; position = (position + 1) & mask) {\
+        I index = indices[position];\
+        if (index == (I) -1) {\
+            return ds_NOT_FOUND;\
+        }\
+        if (entries[index].hash == hash) {\
+            K x = key;\
+            K y = entries[index].key;\
+            if ((x_y_equals)) {\
+                return position;\
+            }\
+        }\
+    }\
+}\
+\
+ds_API static inline ds_size ds__##name##_slot_of(const I *indices, ds_size mask, const E *entries, I index) {\
+    ds_assert(indices != ds_NULL);\
+    ds_size position = entries[index].hash & mask;\
+    while (indices[position] != index) {\
+        ds_assert(indices[position] != (I) -1);\
+        position = (position + 1) & mask;\
+    }\
+    return position;\
+}\
+\
+ds_API static inline void ds__##name##_place(I *indices, ds_size mask, const E *entries, I index) {\
+    ds_assert(indices != ds_NULL);\
+    ds_size position = entries[index].hash & mask;\
+    while (indices[position] != (I) -1) {\
+        position = (position + 1) & mask;\
+    }\
+    indices[position] = index;\
+}\
+\
+ds_API static inline void ds__##name##_remove_slot(I *indices, ds_size mask, const E *entries, ds_size position) {\
+    ds_assert(indices != ds_NULL);\
+    ds_assert(position <= mask);\
+    for (ds_size next = (position + 1) & mask;; next = (next + 1) & mask) {\
+        I index = indices[next];\
+        if (index == (I) -1) {\
+            break;\
+        }\
+        ds_size home = entries[index].hash & mask;\
+        if (((next - home) & mask) >= ((next - position) & mask)) {\
+            indices[position] = index;\
+            position = next;\
+        }\
+    }\
+    indices[position] = (I) -1;\
+}
+
 #endif // DS_DEF_H
@@ -0,0 +1,316 @@
+// .h
+// ds.h Unordered Hash Set Data Structure
+// by Kyle Furey
+
+/**
+ * ds_hashset.h
+ *
+ * ds_DECLARE_HASHSET_NAMED(
+ *      name,           - The name of the data structure and function prefix.
+ *
+ *      T,              - The type to generate this data structure with.
+ *
+ *      key_hasher,     - Inline hashing code used to hash a value named <key>.
+ *                        You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                        ds_FAST_HASH and ds_FAST_STRING_HASH are faster for values larger than a few bytes.
+ *
+ *      x_y_equals,     - Inline comparison code used to equate values <x> and <y>.
+ *                        You can use ds_DEFAULT_EQUALS for trivial types.
+ *
+ *      deleter,        - The name of the function used to deallocate T.
+ *                        ds_void_deleter may be used for trivial types.
+ * )
+ *
+ * This is an open addressing hash set that stores a collection of unique elements.
+ * It is a ds_map.h map whose buckets hold only an element, so it shares the map's probing,
+ * skipped bucket handling, incremental rehashing, and load and shrink factor settings.
+ * Finding, inserting, and erasing elements are near O(1) regardless of insertion order.
+ *
+ * Hash sets are great for membership tests when the order of elements does not matter.
+ * New elements replace "identical" elements on insert.
+ *
+ * * Returns a new hash set with <capacity> number of buckets.
+ * * <capacity> must be greater than 0. Hash sets have at least ds_MAP_GROUP buckets.
+ * * If ds_MAP_POW2 is true, <capacity> is rounded up to a power of two.
+ * * This data structure must be deleted with hashset_delete().
+ *
+ *   hashset      hashset_new         ( size_t capacity )
+ *
+ * * Returns a new hash set copied from <set>.
+ * * The new set owns its own memory and must be deleted with hashset_delete().
+ *
+ *   hashset      hashset_copy        ( const hashset* set )
+ *
+ * * Returns the number of elements in the set.
+ *
+ *   size_t       hashset_count       ( const hashset* self )
+ *
+ * * Returns the number of the buckets in the set.
+ *
+ *   size_t       hashset_capacity    ( const hashset* self )
+ *
+ * * Returns whether the set is empty.
+ *
+ *   bool         hashset_empty       ( const hashset* self )
+ *
+ * * Returns a pointer to a value that matches <data> in the set.
+ * * Returns NULL if no value matches.
+ *
+ *   const T*     hashset_find        ( const hashset* self, T data )
+ *
+ * * Returns whether the set contains <data>.
+ *
+ *   bool         hashset_contains    ( const hashset* self, T data )
+ *
+ * * Makes room for <count> elements in total so they can be inserted without rehashing.
+ *
+ *   void         hashset_reserve     ( hashset* self, size_t count )
+ *
+ * * Shrinks the set to the fewest buckets that hold its elements under the load factor.
+ *
+ *   void         hashset_shrink_to_fit( hashset* self )
+ *
+ * * Removes every skipped bucket by rehashing the set in place without allocating.
+ *
+ *   void         hashset_purge       ( hashset* self )
+ *
+ * * Inserts a new element into the set.
+ * * Returns whether a value was overwritten.
+ *
+ *   bool         hashset_insert      ( hashset* self, T data )
+ *
+ * * Deletes an element in the set.
+ * * If ds_MAP_SHRINK_FACTOR_NUM is not 0, the set shrinks when few enough buckets are full.
+ * * Returns whether an element was deleted.
+ *
+ *   bool         hashset_erase       ( hashset* self, T data )
+ *
+ * * Returns whether <self> is a subset of <set>.
+ * * <or_equal> determines whether set equality returns true.
+ *
+ *   bool         hashset_subset      ( const hashset* self, const hashset* set, bool or_equal )
+ *
+ * * Mutates <self> by inserting all elements in <set> into <self>.
+ * * Returns <self>.
+ *
+ *   hashset*     hashset_union       ( hashset* self, const hashset* set )
+ *
+ * * Mutates <self> by removing elements from <self> not present in <set>.
+ * * Returns <self>.
+ *
+ *   hashset*     hashset_intersect   ( hashset* self, const hashset* set )
+ *
+ * * Mutates <self> by removing elements from <self> present in <set>.
+ * * Returns <self>.
+ *
+ *   hashset*     hashset_difference  ( hashset* self, const hashset* set )
+ *
+ * * Deletes all elements in the set.
+ *
+ *   void         hashset_clear       ( hashset* self )
+ *
+ * * Iterates the set calling <action> on each element.
+ *
+ *   void         hashset_foreach     ( const hashset* self, void (*action)(T) )
+ *
+ * * Returns an iterator positioned before the first element in the set.
+ * * Inserting into the set invalidates its iterators. Erasing the current element does not,
+ * * unless ds_MAP_SHRINK_FACTOR_NUM is not 0 and the set shrinks.
+ *
+ *   hashset_iter hashset_iter_begin  ( const hashset* self )
+ *
+ * * Advances <iter> to the next element in the set and returns a pointer to it.
+ * * Returns NULL once every element has been visited.
+ *
+ *   const T*     hashset_iter_next   ( hashset_iter* iter )
+ *
+ * * Returns the number of full, empty, and skipped buckets in the set,
+ * * the mean, longest, and histogram of its elements' probe lengths, and the bytes it uses per element.
+ *
+ *   ds_map_stats hashset_stats       ( const hashset* self )
+ *
+ * * Safely deletes a set.
+ *
+ *   void         hashset_delete      ( hashset* self )
+ */
+
+#ifndef DS_HASHSET_H
+#define DS_HASHSET_H
+
+#include "ds_map.h"
+
+/** Declares a named unordered hash set of the given type. */
+#define ds_DECLARE_HASHSET_NAMED(name, T, key_hasher, x_y_equals, deleter)\
+\
+ds__DECLARE_SET_BUCKET(ds__##name##_map, T, key_hasher)\
+ds__DECLARE_MAP_CORE(ds__##name##_map, T, T, key_hasher, x_y_equals, deleter, 0)\
+\
+typedef struct {\
+    ds__##name##_map map;\
+} name;\
+\
+typedef struct {\
+    ds__##name##_map_iter iter;\
+} name##_iter;\
+\
+ds_API static inline name name##_new(ds_size capacity) {\
+    return (name) {\
+        ds__##name##_map_new(capacity),\
+    };\
+}\
+\
+ds_API static inline name name##_copy(const name *set) {\
+    ds_assert(set != ds_NULL);\
+    return (name) {\
+        ds__##name##_map_copy(&set->map),\
+    };\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_map_count(&self->map);\
+}\
+\
+ds_API static inline ds_size name##_capacity(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_map_capacity(&self->map);\
+}\
+\
+ds_API static inline ds_bool name##_empty(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_map_empty(&self->map);\
+}\
+\
+ds_API static inline const T *name##_find(const name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_map_find_const(&self->map, data);\
+}\
+\
+ds_API static inline ds_bool name##_contains(const name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_map_contains(&self->map, data);\
+}\
+\
+ds_API static inline void name##_reserve(name *self, ds_size count) {\
+    ds_assert(self != ds_NULL);\
+    ds_size capacity = self->map.buckets.capacity;\
+    if (ds_MAP_LOAD_FACTOR_DEN * (count + self->map.skips) <= ds_MAP_LOAD_FACTOR_NUM * capacity) {\
+        return;\
+    }\
+    ds_size fit = ds__ds__##name##_map_fit(count);\
+    ds__##name##_map_resize(&self->map, fit > capacity ? fit : capacity);\
+}\
+\
+ds_API static inline void name##_shrink_to_fit(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_map_shrink_to_fit(&self->map);\
+}\
+\
+ds_API static inline void name##_purge(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_map_purge(&self->map);\
+}\
+\
+ds_API static inline ds_bool name##_insert(name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_map_insert(&self->map, data, data);\
+}\
+\
+ds_API static inline ds_bool name##_erase(name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_map_erase(&self->map, data);\
+}\
+\
+ds_API static inline name##_iter name##_iter_begin(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return (name##_iter) {\
+        ds__##name##_map_iter_begin((ds__##name##_map *) &self->map),\
+    };\
+}\
+\
+ds_API static inline const T *name##_iter_next(name##_iter *iter) {\
+    ds_assert(iter != ds_NULL);\
+    const T *data;\
+    return ds__##name##_map_iter_next(&iter->iter, &data, ds_NULL) ? data : ds_NULL;\
+}\
+\
+ds_API static inline void name##_clear(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_map_clear(&self->map);\
+}\
+\
+ds_API static inline ds_bool name##_subset(const name *self, const name *set, ds_bool or_equal) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(set != ds_NULL);\
+    if (self->map.count > set->map.count || (!or_equal && self->map.count == set->map.count)) {\
+        return ds_false;\
+    }\
+    name##_iter iter = name##_iter_begin(self);\
+    for (const T *data = name##_iter_next(&iter); data != ds_NULL; data = name##_iter_next(&iter)) {\
+        if (!name##_contains(set, *data)) {\
+            return ds_false;\
+        }\
+    }\
+    return ds_true;\
+}\
+\
+ds_API static inline name *name##_union(name *self, const name *set) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(set != ds_NULL);\
+    if (self == set) {\
+        return self;\
+    }\
+    name##_reserve(self, self->map.count + set->map.count);\
+    name##_iter iter = name##_iter_begin(set);\
+    for (const T *data = name##_iter_next(&iter); data != ds_NULL; data = name##_iter_next(&iter)) {\
+        name##_insert(self, *data);\
+    }\
+    return self;\
+}\
+\
+ds_API static inline name *name##_intersect(name *self, const name *set) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(set != ds_NULL);\
+    name##_iter iter = name##_iter_begin(self);\
+    for (const T *data = name##_iter_next(&iter); data != ds_NULL; data = name##_iter_next(&iter)) {\
+        if (!name##_contains(set, *data)) {\
+            ds__ds__##name##_map_remove(&self->map, *data);\
+        }\
+    }\
+    return self;\
+}\
+\
+ds_API static inline name *name##_difference(name *self, const name *set) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(set != ds_NULL);\
+    if (self == set) {\
+        name##_clear(self);\
+        return self;\
+    }\
+    name##_iter iter = name##_iter_begin(set);\
+    for (const T *data = name##_iter_next(&iter); data != ds_NULL; data = name##_iter_next(&iter)) {\
+        name##_erase(self, *data);\
+    }\
+    return self;\
+}\
+\
+ds_API static inline void name##_foreach(const name *self, void(*action)(T)) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_map_foreach_key(&self->map, action);\
+}\
+\
+ds_API static inline ds_map_stats name##_stats(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_map_stats(&self->map);\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_map_delete(&self->map);\
+}
+
+/** Declares an unordered hash set of the given type. */
+#define ds_DECLARE_HASHSET(T, key_hasher, x_y_equals, deleter)\
+        ds_DECLARE_HASHSET_NAMED(T##_hashset, T, key_hasher, x_y_equals, deleter)
+
+#endif // DS_HASHSET_H
@@ -0,0 +1,325 @@
+// .h
+// ds.h Insertion-Ordered Index Map Data Structure
+// by Kyle Furey
+
+/**
+ * ds_indexmap.h
+ *
+ * ds_DECLARE_INDEXMAP_NAMED(
+ *      name,           - The name of the data structure and function prefix.
+ *
+ *      K,              - The key type used to index V.
+ *
+ *      V,              - The value type to generate this data structure with.
+ *
+ *      key_hasher,     - Inline hashing code used to hash a key named <key>.
+ *                        You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                        ds_FAST_HASH and ds_FAST_STRING_HASH are faster for keys larger than a few bytes.
+ *
+ *      x_y_equals,     - Inline comparison code used to equate keys <x> and <y>.
+ *                        You can use ds_DEFAULT_EQUALS for trivial types.
+ *
+ *      value_deleter,  - The name of the function used to deallocate V.
+ *                        ds_void_deleter may be used for trivial types.
+ * )
+ *
+ * This is a hash map that stores its pairs densely in insertion order.
+ * Pairs live in a vector, and a separate open addressing table stores each pair's index in that vector.
+ * Only the small index table has empty slots, so large values waste no memory and iteration runs over a plain array.
+ *
+ * The index table uses linear probing and shifts indices back on erase, so it never fills with skipped buckets.
+ * Pairs can be read by position from 0 to indexmap_count(), which is also the order indexmap_foreach() uses.
+ * Index maps hold at most UINT_MAX - 1 pairs.
+ *
+ * * Returns a new index map with room for <capacity> pairs.
+ * * <capacity> must be greater than 0.
+ * * This data structure must be deleted with indexmap_delete().
+ *
+ *   indexmap     indexmap_new            ( size_t capacity )
+ *
+ * * Returns a new index map copied from <map>.
+ * * The new map owns its own memory and must be deleted with indexmap_delete().
+ *
+ *   indexmap     indexmap_copy           ( const indexmap* map )
+ *
+ * * Returns the number of pairs in the map.
+ *
+ *   size_t       indexmap_count          ( const indexmap* self )
+ *
+ * * Returns the number of pairs the map can hold before reallocating.
+ *
+ *   size_t       indexmap_capacity       ( const indexmap* self )
+ *
+ * * Returns whether the map is empty.
+ *
+ *   bool         indexmap_empty          ( const indexmap* self )
+ *
+ * * Returns a pointer to the value that matches <key>.
+ * * Returns NULL if no value matches.
+ *
+ *   V*           indexmap_find           ( indexmap* self, K key )
+ *
+ * * Returns a pointer to the value that matches <key>.
+ * * Returns NULL if no value matches.
+ *
+ *   const V*     indexmap_find_const     ( const indexmap* self, K key )
+ *
+ * * Returns whether the map contains <key>.
+ *
+ *   bool         indexmap_contains       ( const indexmap* self, K key )
+ *
+ * * Returns the position of the pair that matches <key>.
+ * * Returns ds_NOT_FOUND if no pair matches.
+ *
+ *   size_t       indexmap_index_of       ( const indexmap* self, K key )
+ *
+ * * Returns a pointer to the key at <index> in insertion order.
+ *
+ *   const K*     indexmap_key_at         ( const indexmap* self, size_t index )
+ *
+ * * Returns a pointer to the value at <index> in insertion order.
+ *
+ *   V*           indexmap_value_at       ( indexmap* self, size_t index )
+ *
+ * * Inserts a new key-value pair at the end of the map.
+ * * If <key> is already present, its value is replaced in place and its position is kept.
+ * * Returns whether a value was overwritten.
+ *
+ *   bool         indexmap_insert         ( indexmap* self, K key, V value )
+ *
+ * * Deletes the value that matches <key> in O(1).
+ * * The last pair is moved into its position, so insertion order is not kept.
+ * * Returns whether <key> was found.
+ *
+ *   bool         indexmap_erase          ( indexmap* self, K key )
+ *
+ * * Deletes the value that matches <key> and shifts every later pair down by one.
+ * * This keeps insertion order but is O(n).
+ * * Returns whether <key> was found.
+ *
+ *   bool         indexmap_erase_ordered  ( indexmap* self, K key )
+ *
+ * * Deletes all pairs in the map.
+ *
+ *   void         indexmap_clear          ( indexmap* self )
+ *
+ * * Iterates the map in insertion order calling <action> on each key and value.
+ *
+ *   void         indexmap_foreach        ( const indexmap* self, void (*action)(K, V) )
+ *
+ * * Safely deletes an index map.
+ *
+ *   void         indexmap_delete         ( indexmap* self )
+ */
+
+#ifndef DS_INDEXMAP_H
+#define DS_INDEXMAP_H
+
+#include "ds_vector.h"
+
+/** The index of an empty slot in an index map's table. */
+#define ds__INDEXMAP_EMPTY ((ds_uint) -1)
+
+/** Declares a named insertion-ordered index map of the given types. */
+#define ds_DECLARE_INDEXMAP_NAMED(name, K, V, key_hasher, x_y_equals, value_deleter)\
+\
+typedef struct {\
+    K key;\
+    V value;\
+    ds_uint hash;\
+} ds__##name##_entry;\
+\
+ds_DECLARE_VECTOR_NAMED(ds__##name##_vector, ds__##name##_entry, ds_void_deleter)\
+\
+typedef struct {\
+    ds__##name##_vector entries;\
+    ds_uint *indices;\
+    ds_size mask;\
+} name;\
+\
+ds__DECLARE_INDEX_TABLE(name, K, ds__##name##_entry, ds_uint, x_y_equals)\
+\
+ds_API static inline ds_uint ds__##name##_hash(K key) {\
+    return (ds_uint) ds_hash_mix((key_hasher));\
+}\
+\
+ds_API static inline void ds__##name##_rebuild(name *self, ds_size slots) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert((slots & (slots - 1)) == 0);\
+    ds_free(self->indices);\
+    self->indices = (ds_uint *) ds_malloc(sizeof(ds_uint) * slots);\
+    ds_assert(self->indices != ds_NULL);\
+    ds_memset(self->indices, 0xFF, sizeof(ds_uint) * slots);\
+    self->mask = slots - 1;\
+    for (ds_size i = 0; i < self->entries.count; ++i) {\
+        ds__##name##_place(self->indices, self->mask, self->entries.array, (ds_uint) i);\
+    }\
+}\
+\
+ds_API static inline name name##_new(ds_size capacity) {\
+    ds_assert(capacity > 0);\
+    name self = (name) {\
+        ds__##name##_vector_new(capacity),\
+        ds_NULL,\
+        0,\
+    };\
+    ds__##name##_rebuild(&self, ds__##name##_slots(capacity));\
+    return self;\
+}\
+\
+ds_API static inline name name##_copy(const name *map) {\
+    ds_assert(map != ds_NULL);\
+    ds_assert(map->indices != ds_NULL);\
+    name self = (name) {\
+        ds__##name##_vector_copy(&map->entries),\
+        (ds_uint *) ds_malloc(sizeof(ds_uint) * (map->mask + 1)),\
+        map->mask,\
+    };\
+    ds_assert(self.indices != ds_NULL);\
+    ds_memcpy(self.indices, map->indices, sizeof(ds_uint) * (map->mask + 1));\
+    return self;\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->entries.count;\
+}\
+\
+ds_API static inline ds_size name##_capacity(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->entries.capacity;\
+}\
+\
+ds_API static inline ds_bool name##_empty(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->entries.count == 0;\
+}\
+\
+ds_API static inline ds_size name##_index_of(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_size position = ds__##name##_probe(self->indices, self->mask, self->entries.array, key, ds__##name##_hash(key));\
+    return position != ds_NOT_FOUND ? self->indices[position] : ds_NOT_FOUND;\
+}\
+\
+ds_API static inline V *name##_find(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_size index = name##_index_of(self, key);\
+    return index != ds_NOT_FOUND ? &self->entries.array[index].value : ds_NULL;\
+}\
+\
+ds_API static inline const V *name##_find_const(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_size index = name##_index_of(self, key);\
+    return index != ds_NOT_FOUND ? &self->entries.array[index].value : ds_NULL;\
+}\
+\
+ds_API static inline ds_bool name##_contains(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    return name##_index_of(self, key) != ds_NOT_FOUND;\
+}\
+\
+ds_API static inline const K *name##_key_at(const name *self, ds_size index) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(index < self->entries.count);\
+    return &self->entries.array[index].key;\
+}\
+\
+ds_API static inline V *name##_value_at(name *self, ds_size index) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(index < self->entries.count);\
+    return &self->entries.array[index].value;\
+}\
+\
+ds_API static inline ds_bool name##_insert(name *self, K key, V value) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->indices != ds_NULL);\
+    ds_uint hash = ds__##name##_hash(key);\
+    ds_size position = ds__##name##_probe(self->indices, self->mask, self->entries.array, key, hash);\
+    if (position != ds_NOT_FOUND) {\
+        V *old = &self->entries.array[self->indices[position]].value;\
+        value_deleter(old);\
+        *old = value;\
+        return ds_true;\
+    }\
+    ds_assert(self->entries.count < ds__INDEXMAP_EMPTY);\
+    if (ds_MAP_LOAD_FACTOR_DEN * (self->entries.count + 1) > ds_MAP_LOAD_FACTOR_NUM * (self->mask + 1)) {\
+        ds__##name##_rebuild(self, (self->mask + 1) * 2);\
+    }\
+    ds__##name##_vector_push(&self->entries, (ds__##name##_entry) {\
+        key,\
+        value,\
+        hash,\
+    });\
+    ds__##name##_place(self->indices, self->mask, self->entries.array, (ds_uint) (self->entries.count - 1));\
+    return ds_false;\
+}\
+\
+ds_API static inline ds_bool name##_erase(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->indices != ds_NULL);\
+    ds_size position = ds__##name##_probe(self->indices, self->mask, self->entries.array, key, ds__##name##_hash(key));\
+    if (position == ds_NOT_FOUND) {\
+        return ds_false;\
+    }\
+    ds_size index = self->indices[position];\
+    ds_size last = self->entries.count - 1;\
+    ds__##name##_remove_slot(self->indices, self->mask, self->entries.array, position);\
+    value_deleter(&self->entries.array[index].value);\
+    if (index != last) {\
+        self->indices[ds__##name##_slot_of(self->indices, self->mask, self->entries.array, (ds_uint) last)] = (ds_uint) index;\
+        self->entries.array[index] = self->entries.array[last];\
+    }\
+    ds__##name##_vector_pop(&self->entries);\
+    return ds_true;\
+}\
+\
+ds_API static inline ds_bool name##_erase_ordered(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->indices != ds_NULL);\
+    ds_size position = ds__##name##_probe(self->indices, self->mask, self->entries.array, key, ds__##name##_hash(key));\
+    if (position == ds_NOT_FOUND) {\
+        return ds_false;\
+    }\
+    ds_uint index = self->indices[position];\
+    ds__##name##_remove_slot(self->indices, self->mask, self->entries.array, position);\
+    value_deleter(&self->entries.array[index].value);\
+    ds__##name##_vector_erase(&self->entries, index);\
+    for (ds_size i = 0; i <= self->mask; ++i) {\
+        if (self->indices[i] != ds__INDEXMAP_EMPTY && self->indices[i] > index) {\
+            --self->indices[i];\
+        }\
+    }\
+    return ds_true;\
+}\
+\
+ds_API static inline void name##_clear(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->indices != ds_NULL);\
+    for (ds_size i = 0; i < self->entries.count; ++i) {\
+        value_deleter(&self->entries.array[i].value);\
+    }\
+    ds__##name##_vector_clear(&self->entries);\
+    ds_memset(self->indices, 0xFF, sizeof(ds_uint) * (self->mask + 1));\
+}\
+\
+ds_API static inline void name##_foreach(const name *self, void(*action)(K, V)) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(action != ds_NULL);\
+    for (ds_size i = 0; i < self->entries.count; ++i) {\
+        action(self->entries.array[i].key, self->entries.array[i].value);\
+    }\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    name##_clear(self);\
+    ds__##name##_vector_delete(&self->entries);\
+    ds_free(self->indices);\
+    *self = (name) {0};\
+}
+
+/** Declares an insertion-ordered index map of the given types. */
+#define ds_DECLARE_INDEXMAP(K, V, key_hasher, x_y_equals, value_deleter)\
+        ds_DECLARE_INDEXMAP_NAMED(K##_##V##_indexmap, K, V, key_hasher, x_y_equals, value_deleter)
+
+#endif // DS_INDEXMAP_H
@@ -0,0 +1,390 @@
+// .h
+// ds.h Interval Tree Data Structure
+// by Kyle Furey
+
+/**
+ * ds_interval.h
+ *
+ * ds_DECLARE_INTERVAL_NAMED(
+ *      name,               - The name of the data structure and function prefix.
+ *
+ *      T,                  - The type to generate this data structure with.
+ *
+ *      P,                  - The type of each interval's endpoints.
+ *
+ *      x_y_comparer,       - Inline comparison code used to compare endpoints <x> and <y>.
+ *                            You can use ds_DEFAULT_COMPARE for trivial types.
+ *
+ *      x_y_equals,         - Inline comparison code used to equate values <x> and <y>.
+ *                            You can use ds_DEFAULT_EQUALS for trivial types.
+ *
+ *      deleter,            - The name of the function used to deallocate T.
+ *                            ds_void_deleter may be used for trivial types.
+ * )
+ *
+ * This is an interval tree. It stores values over closed ranges of endpoints [low, high].
+ * Intervals are kept in a balanced AVL tree sorted by their low and then high endpoint.
+ * Each node also stores the greatest high endpoint in its subtree.
+ *
+ * That maximum lets queries skip every subtree that ends before the queried range.
+ * Finding all k intervals containing a point or overlapping a range is O(log n + k).
+ *
+ * This is excellent for time ranges, address ranges, and other spans of ordered values.
+ * The same interval can be inserted multiple times with different values.
+ *
+ * * Returns a new interval tree.
+ * * This data structure must be deleted with interval_delete().
+ *
+ *   interval     interval_new            ( void )
+ *
+ * * Returns a new interval tree copied from <interval>.
+ * * The new tree owns its own memory and must be deleted with interval_delete().
+ *
+ *   interval     interval_copy           ( const interval* interval )
+ *
+ * * Returns the number of intervals in the tree.
+ *
+ *   size_t       interval_count          ( const interval* self )
+ *
+ * * Returns whether the tree is empty.
+ *
+ *   bool         interval_empty          ( const interval* self )
+ *
+ * * Inserts <data> over the interval [<low>, <high>].
+ * * <low> must not be greater than <high>.
+ *
+ *   void         interval_insert         ( interval* self, P low, P high, T data )
+ *
+ * * Deletes a value that matches <data> over the interval [<low>, <high>].
+ * * Returns whether a value was deleted.
+ *
+ *   bool         interval_erase          ( interval* self, P low, P high, T data )
+ *
+ * * Calls <action> on each interval that contains <point>.
+ * * <action> may be NULL to only count intervals.
+ * * Returns the number of intervals found.
+ *
+ *   size_t       interval_stab           ( const interval* self, P point, void (*action)(P, P, T) )
+ *
+ * * Calls <action> on each interval that overlaps [<low>, <high>].
+ * * <action> may be NULL to only count intervals.
+ * * Returns the number of intervals found.
+ *
+ *   size_t       interval_overlaps       ( const interval* self, P low, P high, void (*action)(P, P, T) )
+ *
+ * * Deletes all intervals in the tree.
+ *
+ *   void         interval_clear          ( interval* self )
+ *
+ * * Iterates the tree in-order calling <action> on each interval.
+ *
+ *   void         interval_foreach        ( const interval* self, void (*action)(P, P, T) )
+ *
+ * * Safely deletes an interval tree.
+ *
+ *   void         interval_delete         ( interval* self )
+ */
+
+#ifndef DS_INTERVAL_H
+#define DS_INTERVAL_H
+
+#include "ds_def.h"
+
+/** Declares a named interval tree of the given types. */
+#define ds_DECLARE_INTERVAL_NAMED(name, T, P, x_y_comparer, x_y_equals, deleter)\
+\
+typedef struct ds__##name##_node {\
+    P low;\
+    P high;\
+    P max;\
+    T data;\
+    struct ds__##name##_node *left;\
+    struct ds__##name##_node *right;\
+    ds_uint height;\
+} ds__##name##_node;\
+\
+typedef struct {\
+    ds_size count;\
+    ds__##name##_node *root;\
+} name;\
+\
+ds_API static inline ds_bool ds__##name##_greater(P x, P y) {\
+    return (x_y_comparer);\
+}\
+\
+ds_API static inline ds_int ds__##name##_order(P low, P high, const ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL);\
+    if (ds__##name##_greater(node->low, low)) {\
+        return -1;\
+    }\
+    if (ds__##name##_greater(low, node->low)) {\
+        return 1;\
+    }\
+    if (ds__##name##_greater(node->high, high)) {\
+        return -1;\
+    }\
+    if (ds__##name##_greater(high, node->high)) {\
+        return 1;\
+    }\
+    return 0;\
+}\
+\
+ds_API static inline ds_uint ds__##name##_height(const ds__##name##_node *node) {\
+    return node != ds_NULL ? node->height : 0;\
+}\
+\
+ds_API static inline void ds__##name##_update(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL);\
+    ds_uint left = ds__##name##_height(node->left);\
+    ds_uint right = ds__##name##_height(node->right);\
+    node->height = (left > right ? left : right) + 1;\
+    node->max = node->high;\
+    if (node->left != ds_NULL && ds__##name##_greater(node->left->max, node->max)) {\
+        node->max = node->left->max;\
+    }\
+    if (node->right != ds_NULL && ds__##name##_greater(node->right->max, node->max)) {\
+        node->max = node->right->max;\
+    }\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_rotate_left(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL && node->right != ds_NULL);\
+    ds__##name##_node *right = node->right;\
+    node->right = right->left;\
+    right->left = node;\
+    ds__##name##_update(node);\
+    ds__##name##_update(right);\
+    return right;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_rotate_right(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL && node->left != ds_NULL);\
+    ds__##name##_node *left = node->left;\
+    node->left = left->right;\
+    left->right = node;\
+    ds__##name##_update(node);\
+    ds__##name##_update(left);\
+    return left;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_balance(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL);\
+    ds__##name##_update(node);\
+    ds_uint left = ds__##name##_height(node->left);\
+    ds_uint right = ds__##name##_height(node->right);\
+    if (left > right + 1) {\
+        if (ds__##name##_height(node->left->left) < ds__##name##_height(node->left->right)) {\
+            node->left = ds__##name##_rotate_left(node->left);\
+        }\
+        return ds__##name##_rotate_right(node);\
+    }\
+    if (right > left + 1) {\
+        if (ds__##name##_height(node->right->right) < ds__##name##_height(node->right->left)) {\
+            node->right = ds__##name##_rotate_right(node->right);\
+        }\
+        return ds__##name##_rotate_left(node);\
+    }\
+    return node;\
+}\
+\
+ds_API static inline name name##_new(void) {\
+    return (name) {\
+        0,\
+        ds_NULL,\
+    };\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_copy(const ds__##name##_node *node) {\
+    if (node == ds_NULL) {\
+        return ds_NULL;\
+    }\
+    ds__##name##_node *copy = (ds__##name##_node *) ds_malloc(sizeof(ds__##name##_node));\
+    ds_assert(copy != ds_NULL);\
+    *copy = *node;\
+    copy->left = ds__##name##_copy(node->left);\
+    copy->right = ds__##name##_copy(node->right);\
+    return copy;\
+}\
+\
+ds_API static inline name name##_copy(const name *interval) {\
+    ds_assert(interval != ds_NULL);\
+    ds_assert((interval->root == ds_NULL) == (interval->count == 0));\
+    return (name) {\
+        interval->count,\
+        ds__##name##_copy(interval->root),\
+    };\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->count;\
+}\
+\
+ds_API static inline ds_bool name##_empty(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->count == 0;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_insert(ds__##name##_node *node, P low, P high, T data) {\
+    if (node == ds_NULL) {\
+        node = (ds__##name##_node *) ds_malloc(sizeof(ds__##name##_node));\
+        ds_assert(node != ds_NULL);\
+        node->low = low;\
+        node->high = high;\
+        node->max = high;\
+        node->data = data;\
+        node->left = ds_NULL;\
+        node->right = ds_NULL;\
+        node->height = 1;\
+        return node;\
+    }\
+    if (ds__##name##_order(low, high, node) < 0) {\
+        node->left = ds__##name##_insert(node->left, low, high, data);\
+    } else {\
+        node->right = ds__##name##_insert(node->right, low, high, data);\
+    }\
+    return ds__##name##_balance(node);\
+}\
+\
+ds_API static inline void name##_insert(name *self, P low, P high, T data) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(!ds__##name##_greater(low, high));\
+    self->root = ds__##name##_insert(self->root, low, high, data);\
+    ++self->count;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_erase_least(ds__##name##_node *node, ds__##name##_node **least) {\
+    ds_assert(node != ds_NULL && least != ds_NULL);\
+    if (node->left == ds_NULL) {\
+        *least = node;\
+        return node->right;\
+    }\
+    node->left = ds__##name##_erase_least(node->left, least);\
+    return ds__##name##_balance(node);\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_erase(ds__##name##_node *node, P low, P high, T data, ds_bool *erased) {\
+    ds_assert(erased != ds_NULL);\
+    if (node == ds_NULL) {\
+        return ds_NULL;\
+    }\
+    ds_int order = ds__##name##_order(low, high, node);\
+    if (order < 0) {\
+        node->left = ds__##name##_erase(node->left, low, high, data, erased);\
+    } else if (order > 0) {\
+        node->right = ds__##name##_erase(node->right, low, high, data, erased);\
+    } else {\
+        T x = data;\
+        T y = node->data;\
+        if ((x_y_equals)) {\
+            *erased = ds_true;\
+            deleter(&node->data);\
+            ds__##name##_node *replace;\
+            if (node->left == ds_NULL || node->right == ds_NULL) {\
+                replace = node->left != ds_NULL ? node->left : node->right;\
+                ds_free(node);\
+                return replace;\
+            }\
+            node->right = ds__##name##_erase_least(node->right, &replace);\
+            replace->left = node->left;\
+            replace->right = node->right;\
+            ds_free(node);\
+            return ds__##name##_balance(replace);\
+        }\
+        node->left = ds__##name##_erase(node->left, low, high, data, erased);\
+        if (!*erased) {\
+            node->right = ds__##name##_erase(node->right, low, high, data, erased);\
+        }\
+    }\
+    return ds__##name##_balance(node);\
+}\
+\
+ds_API static inline ds_bool name##_erase(name *self, P low, P high, T data) {\
+    ds_assert(self != ds_NULL);\
+    ds_bool erased = ds_false;\
+    self->root = ds__##name##_erase(self->root, low, high, data, &erased);\
+    if (erased) {\
+        ds_assert(self->count > 0);\
+        --self->count;\
+    }\
+    return erased;\
+}\
+\
+ds_API static inline ds_size ds__##name##_overlaps(const ds__##name##_node *node, P low, P high, void(*action)(P, P, T)) {\
+    ds_size total = 0;\
+    while (node != ds_NULL && !ds__##name##_greater(low, node->max)) {\
+        total += ds__##name##_overlaps(node->left, low, high, action);\
+        if (ds__##name##_greater(node->low, high)) {\
+            break;\
+        }\
+        if (!ds__##name##_greater(low, node->high)) {\
+            if (action != ds_NULL) {\
+                action(node->low, node->high, node->data);\
+            }\
+            ++total;\
+        }\
+        node = node->right;\
+    }\
+    return total;\
+}\
+\
+ds_API static inline ds_size name##_overlaps(const name *self, P low, P high, void(*action)(P, P, T)) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(!ds__##name##_greater(low, high));\
+    return ds__##name##_overlaps(self->root, low, high, action);\
+}\
+\
+ds_API static inline ds_size name##_stab(const name *self, P point, void(*action)(P, P, T)) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_overlaps(self->root, point, point, action);\
+}\
+\
+ds_API static inline void ds__##name##_clear(ds__##name##_node *node) {\
+    while (node != ds_NULL) {\
+        ds__##name##_node *right = node->right;\
+        ds__##name##_clear(node->left);\
+        deleter(&node->data);\
+        ds_free(node);\
+        node = right;\
+    }\
+}\
+\
+ds_API static inline void name##_clear(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert((self->root == ds_NULL) == (self->count == 0));\
+    ds__##name##_clear(self->root);\
+    self->count = 0;\
+    self->root = ds_NULL;\
+}\
+\
+ds_API static inline void ds__##name##_foreach(const ds__##name##_node *node, void(*action)(P, P, T)) {\
+    ds_assert(node != ds_NULL && action != ds_NULL);\
+    if (node->left != ds_NULL) {\
+        ds__##name##_foreach(node->left, action);\
+    }\
+    action(node->low, node->high, node->data);\
+    if (node->right != ds_NULL) {\
+        ds__##name##_foreach(node->right, action);\
+    }\
+}\
+\
+ds_API static inline void name##_foreach(const name *self, void(*action)(P, P, T)) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(action != ds_NULL);\
+    ds_assert((self->root == ds_NULL) == (self->count == 0));\
+    if (self->root != ds_NULL) {\
+        ds__##name##_foreach(self->root, action);\
+    }\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    name##_clear(self);\
+    *self = (name) {0};\
+}
+
+/** Declares an interval tree of the given types. */
+#define ds_DECLARE_INTERVAL(T, P, x_y_comparer, x_y_equals, deleter)\
+        ds_DECLARE_INTERVAL_NAMED(T##_##P##_interval, T, P, x_y_comparer, x_y_equals, deleter)
+
+#endif // DS_INTERVAL_H
@@ -0,0 +1,301 @@
+// .h
+// ds.h Least Recently Used Cache Data Structure
+// by Kyle Furey
+
+/**
+ * ds_lru.h
+ *
+ * ds_DECLARE_LRU_NAMED(
+ *      name,           - The name of the data structure and function prefix.
+ *
+ *      K,              - The key type used to index V.
+ *
+ *      V,              - The value type to generate this data structure with.
+ *
+ *      key_hasher,     - Inline hashing code used to hash a key named <key>.
+ *                        You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                        ds_FAST_HASH and ds_FAST_STRING_HASH are faster for keys larger than a few bytes.
+ *
+ *      x_y_equals,     - Inline comparison code used to equate keys <x> and <y>.
+ *                        You can use ds_DEFAULT_EQUALS for trivial types.
+ *
+ *      value_deleter,  - The name of the function used to deallocate V.
+ *                        It is also called on each value evicted from the cache.
+ *                        ds_void_deleter may be used for trivial types.
+ * )
+ *
+ * This is a key-value cache with a fixed capacity that evicts its least recently used pair when full.
+ * Pairs live in one preallocated pool of nodes linked from most to least recently used with 32-bit indices.
+ * An open addressing table of node indices finds keys, and shifts indices back on erase so it never fills with skipped buckets.
+ *
+ * Everything is allocated by lru_new(). Getting, putting, evicting, and erasing never allocate and are O(1).
+ * LRU caches hold at most UINT32_MAX - 1 pairs.
+ *
+ * * Returns a new empty cache that holds up to <capacity> pairs.
+ * * <capacity> must be greater than 0.
+ * * This data structure must be deleted with lru_delete().
+ *
+ *   lru          lru_new         ( size_t capacity )
+ *
+ * * Returns the number of pairs in the cache.
+ *
+ *   size_t       lru_count       ( const lru* self )
+ *
+ * * Returns the maximum number of pairs in the cache.
+ *
+ *   size_t       lru_capacity    ( const lru* self )
+ *
+ * * Returns whether the cache is empty.
+ *
+ *   bool         lru_empty       ( const lru* self )
+ *
+ * * Returns a pointer to the value that matches <key> and marks it as the most recently used.
+ * * Returns NULL if no value matches.
+ *
+ *   V*           lru_get         ( lru* self, K key )
+ *
+ * * Returns a pointer to the value that matches <key> without marking it as used.
+ * * Returns NULL if no value matches.
+ *
+ *   const V*     lru_peek        ( const lru* self, K key )
+ *
+ * * Returns whether the cache contains <key>. It is not marked as used.
+ *
+ *   bool         lru_contains    ( const lru* self, K key )
+ *
+ * * Inserts a key-value pair as the most recently used pair.
+ * * If the cache is full, the least recently used pair is evicted with value_deleter first.
+ * * Returns whether a value was overwritten.
+ *
+ *   bool         lru_put         ( lru* self, K key, V value )
+ *
+ * * Deletes the value that matches <key>.
+ * * Returns whether <key> was found.
+ *
+ *   bool         lru_erase       ( lru* self, K key )
+ *
+ * * Deletes all pairs in the cache.
+ *
+ *   void         lru_clear       ( lru* self )
+ *
+ * * Iterates the cache from the most to the least recently used pair calling <action> on each key and value.
+ *
+ *   void         lru_foreach     ( const lru* self, void (*action)(K, V) )
+ *
+ * * Safely deletes an LRU cache.
+ *
+ *   void         lru_delete      ( lru* self )
+ */
+
+#ifndef DS_LRU_H
+#define DS_LRU_H
+
+#include "ds_def.h"
+
+/** The index of a missing node or an empty slot in an LRU cache. */
+#define ds__LRU_NONE ((uint32_t) -1)
+
+/** Declares a named LRU cache of the given types. */
+#define ds_DECLARE_LRU_NAMED(name, K, V, key_hasher, x_y_equals, value_deleter)\
+\
+typedef struct {\
+    K key;\
+    V value;\
+    uint32_t hash;\
+    uint32_t prev;\
+    uint32_t next;\
+} ds__##name##_node;\
+\
+typedef struct {\
+    ds__##name##_node *nodes;\
+    uint32_t *indices;\
+    ds_size mask;\
+    uint32_t capacity;\
+    uint32_t count;\
+    uint32_t head;\
+    uint32_t tail;\
+    uint32_t unused;\
+} name;\
+\
+ds__DECLARE_INDEX_TABLE(name, K, ds__##name##_node, uint32_t, x_y_equals)\
+\
+ds_API static inline uint32_t ds__##name##_hash(K key) {\
+    return (uint32_t) ds_hash_mix((key_hasher));\
+}\
+\
+ds_API static inline void ds__##name##_unlink(name *self, uint32_t index) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_node *node = self->nodes + index;\
+    if (node->prev != ds__LRU_NONE) {\
+        self->nodes[node->prev].next = node->next;\
+    } else {\
+        self->head = node->next;\
+    }\
+    if (node->next != ds__LRU_NONE) {\
+        self->nodes[node->next].prev = node->prev;\
+    } else {\
+        self->tail = node->prev;\
+    }\
+}\
+\
+ds_API static inline void ds__##name##_link_front(name *self, uint32_t index) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_node *node = self->nodes + index;\
+    node->prev = ds__LRU_NONE;\
+    node->next = self->head;\
+    if (self->head != ds__LRU_NONE) {\
+        self->nodes[self->head].prev = index;\
+    } else {\
+        self->tail = index;\
+    }\
+    self->head = index;\
+}\
+\
+ds_API static inline name name##_new(ds_size capacity) {\
+    ds_assert(capacity > 0 && capacity < ds__LRU_NONE);\
+    ds_size slots = ds__##name##_slots(capacity);\
+    name self = (name) {\
+        (ds__##name##_node *) ds_malloc(sizeof(ds__##name##_node) * capacity),\
+        (uint32_t *) ds_malloc(sizeof(uint32_t) * slots),\
+        slots - 1,\
+        (uint32_t) capacity,\
+        0,\
+        ds__LRU_NONE,\
+        ds__LRU_NONE,\
+        0,\
+    };\
+    ds_assert(self.nodes != ds_NULL);\
+    ds_assert(self.indices != ds_NULL);\
+    ds_memset(self.indices, 0xFF, sizeof(uint32_t) * slots);\
+    for (uint32_t i = 0; i < self.capacity; ++i) {\
+        self.nodes[i].next = i + 1 < self.capacity ? i + 1 : ds__LRU_NONE;\
+    }\
+    return self;\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->count;\
+}\
+\
+ds_API static inline ds_size name##_capacity(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->capacity;\
+}\
+\
+ds_API static inline ds_bool name##_empty(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->count == 0;\
+}\
+\
+ds_API static inline V *name##_get(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_size position = ds__##name##_probe(self->indices, self->mask, self->nodes, key, ds__##name##_hash(key));\
+    if (position == ds_NOT_FOUND) {\
+        return ds_NULL;\
+    }\
+    uint32_t index = self->indices[position];\
+    if (index != self->head) {\
+        ds__##name##_unlink(self, index);\
+        ds__##name##_link_front(self, index);\
+    }\
+    return &self->nodes[index].value;\
+}\
+\
+ds_API static inline const V *name##_peek(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_size position = ds__##name##_probe(self->indices, self->mask, self->nodes, key, ds__##name##_hash(key));\
+    return position != ds_NOT_FOUND ? &self->nodes[self->indices[position]].value : ds_NULL;\
+}\
+\
+ds_API static inline ds_bool name##_contains(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_probe(self->indices, self->mask, self->nodes, key, ds__##name##_hash(key)) != ds_NOT_FOUND;\
+}\
+\
+ds_API static inline ds_bool name##_put(name *self, K key, V value) {\
+    ds_assert(self != ds_NULL);\
+    uint32_t hash = ds__##name##_hash(key);\
+    ds_size position = ds__##name##_probe(self->indices, self->mask, self->nodes, key, hash);\
+    if (position != ds_NOT_FOUND) {\
+        uint32_t index = self->indices[position];\
+        value_deleter(&self->nodes[index].value);\
+        self->nodes[index].value = value;\
+        if (index != self->head) {\
+            ds__##name##_unlink(self, index);\
+            ds__##name##_link_front(self, index);\
+        }\
+        return ds_true;\
+    }\
+    uint32_t index;\
+    if (self->count == self->capacity) {\
+        index = self->tail;\
+        ds__##name##_remove_slot(self->indices, self->mask, self->nodes, ds__##name##_slot_of(self->indices, self->mask, self->nodes, index));\
+        ds__##name##_unlink(self, index);\
+        value_deleter(&self->nodes[index].value);\
+    } else {\
+        index = self->unused;\
+        self->unused = self->nodes[index].next;\
+        ++self->count;\
+    }\
+    self->nodes[index].key = key;\
+    self->nodes[index].value = value;\
+    self->nodes[index].hash = hash;\
+    ds__##name##_place(self->indices, self->mask, self->nodes, index);\
+    ds__##name##_link_front(self, index);\
+    return ds_false;\
+}\
+\
+ds_API static inline ds_bool name##_erase(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_size position = ds__##name##_probe(self->indices, self->mask, self->nodes, key, ds__##name##_hash(key));\
+    if (position == ds_NOT_FOUND) {\
+        return ds_false;\
+    }\
+    uint32_t index = self->indices[position];\
+    ds__##name##_remove_slot(self->indices, self->mask, self->nodes, position);\
+    ds__##name##_unlink(self, index);\
+    value_deleter(&self->nodes[index].value);\
+    self->nodes[index].next = self->unused;\
+    self->unused = index;\
+    --self->count;\
+    return ds_true;\
+}\
+\
+ds_API static inline void name##_clear(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->nodes != ds_NULL);\
+    for (uint32_t index = self->head; index != ds__LRU_NONE; index = self->nodes[index].next) {\
+        value_deleter(&self->nodes[index].value);\
+    }\
+    for (uint32_t i = 0; i < self->capacity; ++i) {\
+        self->nodes[i].next = i + 1 < self->capacity ? i + 1 : ds__LRU_NONE;\
+    }\
+    ds_memset(self->indices, 0xFF, sizeof(uint32_t) * (self->mask + 1));\
+    self->count = 0;\
+    self->head = ds__LRU_NONE;\
+    self->tail = ds__LRU_NONE;\
+    self->unused = 0;\
+}\
+\
+ds_API static inline void name##_foreach(const name *self, void(*action)(K, V)) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(action != ds_NULL);\
+    for (uint32_t index = self->head; index != ds__LRU_NONE; index = self->nodes[index].next) {\
+        action(self->nodes[index].key, self->nodes[index].value);\
+    }\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    name##_clear(self);\
+    ds_free(self->nodes);\
+    ds_free(self->indices);\
+    *self = (name) {0};\
+}
+
+/** Declares an LRU cache of the given types. */
+#define ds_DECLARE_LRU(K, V, key_hasher, x_y_equals, value_deleter)\
+        ds_DECLARE_LRU_NAMED(K##_##V##_lru, K, V, key_hasher, x_y_equals, value_deleter)
+
+#endif // DS_LRU_H
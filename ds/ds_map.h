@@ -14,6 +14,7 @@
  *
  *      key_hasher,     - Inline hashing code used to hash a key named <key>.
  *                        You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                        ds_FAST_HASH and ds_FAST_STRING_HASH are faster for keys larger than a few bytes.
  *
  *      x_y_equals,     - Inline comparison code used to equate keys <x> and <y>.
  *                        You can use ds_DEFAULT_EQUALS for trivial types.
@@ -22,15 +23,77 @@
  *                        ds_void_deleter may be used for trivial types.
  * )
  *
+ * ds_DECLARE_CACHED_MAP_NAMED(
+ *      name,           - The name of the data structure and function prefix.
+ *
+ *      K,              - The key type used to index V.
+ *
+ *      V,              - The value type to generate this data structure with.
+ *
+ *      key_hasher,     - Inline hashing code used to hash a key named <key>.
+ *                        You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                        ds_FAST_HASH and ds_FAST_STRING_HASH are faster for keys larger than a few bytes.
+ *
+ *      x_y_equals,     - Inline comparison code used to equate keys <x> and <y>.
+ *                        You can use ds_DEFAULT_EQUALS for trivial types.
+ *
+ *      value_deleter,  - The name of the function used to deallocate V.
+ *                        ds_void_deleter may be used for trivial types.
+ * )
+ *
+ * ds_DECLARE_MAP_BYTES(
+ *      name,               - The name of a map declared above whose keys are strings.
+ *
+ *      V,                  - The map's value type.
+ *
+ *      bytes_hasher,       - Inline hashing code used to hash <size> bytes at <data>.
+ *                            It must hash a key's characters exactly like the map's key_hasher.
+ *                            Use ds_BYTES_HASH with ds_STRING_HASH, or ds_FAST_BYTES_HASH with ds_FAST_STRING_HASH.
+ *
+ *      key_bytes_equals,   - Inline comparison code used to equate a string <key> with <size> bytes at <data>.
+ *                            You can use ds_BYTES_EQUALS.
+ * )
+ *
  * This is a simple open addressing key-value hash map.
  * Values are stored in buckets in an underlying vector.
  * Values are indexed by hashing their key type into a number for near O(1) operations.
  * This number is used to probe for finding where an element may be quickly.
+ * Hashes are mixed with ds_hash_mix() first, so even ds_INT_HASH spreads sequential keys apart.
+ *
+ * Each bucket has a control byte stored in a separate array holding 7 bits of its key's hash.
+ * Probing compares a group of ds_MAP_GROUP control bytes at once, using SSE2 when available.
+ * Keys are only compared in buckets whose control byte matches, which is usually just one.
+ *
+ * Erasing only leaves a skipped bucket behind when a probe may have passed over it.
+ * Otherwise the bucket is emptied, so probes still stop at the first group with an empty bucket.
+ * When skipped buckets fill the map, it is rehashed at the same capacity to remove them.
+ * map_purge() removes them sooner without allocating, and map_shrink_to_fit() returns memory after mass erases.
+ * If ds_MAP_SHRINK_FACTOR_NUM / ds_MAP_SHRINK_FACTOR_DEN is set, erasing shrinks a map whose full buckets fall below it.
+ * This is off by default so erasing never moves pairs.
+ *
+ * If ds_MAP_INCREMENTAL_REHASH is true, rehashing keeps the old buckets beside the new ones.
+ * Each insert and find moves ds_MAP_REHASH_STEP old buckets over, and lookups check both until done.
+ * This avoids long pauses when a large map grows.
+ *
+ * Cached maps store each key's full hash in its bucket.
+ * Rehashing never calls key_hasher, and probes compare hashes before calling x_y_equals.
+ * Prefer them when hashing or comparing keys is expensive, like with strings.
+ *
+ * map_stats() shows whether a key_hasher is clustering keys.
+ * A key's probe length is the number of groups of ds_MAP_GROUP control bytes searched to find it, so 1 is ideal.
+ * The histogram counts keys by probe length, and its last element also counts every longer probe.
+ * If ds_MAP_COUNT_PROBES is true, each find, insert, and erase also counts the groups it probes for map_probes().
+ * These counts are shared by every map of one type in a source file and are not thread safe.
+ *
+ * Maps with string keys can also be searched by a pointer and length with ds_DECLARE_MAP_BYTES().
+ * This finds tokens inside a larger buffer without copying them into null-terminated strings first.
+ * With ds_BYTES_EQUALS, bytes that contain a null character never match, and <data> may be NULL when <size> is 0.
  *
  * It's one of the fastest options for storing, finding, and removing key-value pairs.
  *
  * * Returns a new map with <capacity> number of buckets.
- * * <capacity> must be greater than 0.
+ * * <capacity> must be greater than 0. Maps have at least ds_MAP_GROUP buckets.
+ * * If ds_MAP_POW2 is true, <capacity> is rounded up to a power of two.
  * * This data structure must be deleted with map_delete().
  *
  *   map          map_new             ( size_t capacity )
@@ -62,21 +125,71 @@
  *
  *   const V*     map_find_const      ( const map* self, K key )
  *
+ * * Returns the hash the map uses for <key>.
+ *
+ *   size_t       map_hash            ( K key )
+ *
+ * * Returns a pointer to a value that matches <key> in the map.
+ * * <hash> must be map_hash(<key>), so a key can be hashed once for many lookups.
+ * * Returns NULL if no key is found.
+ *
+ *   V*           map_find_hashed     ( map* self, K key, size_t hash )
+ *
+ * * Searches for each of the <count> keys in <keys>, prefetching the buckets of the next ds_MAP_BATCH keys.
+ * * This overlaps the cache misses of many lookups into a large map.
+ * * Each of <values> is set to a pointer to the matching value or NULL. These stay valid until the map is modified.
+ * * Returns the number of keys found.
+ *
+ *   size_t       map_find_batch      ( map* self, const K* keys, size_t count, V** values )
+ *
  * * Returns whether the map contains <key>.
  *
  *   bool         map_contains        ( const map* self, K key )
  *
+ * * Returns a pointer to the value whose string key equals the <size> bytes at <data>.
+ * * Returns NULL if no value matches. Requires ds_DECLARE_MAP_BYTES().
+ *
+ *   V*           map_find_bytes      ( map* self, const char* data, size_t size )
+ *
+ * * Returns a pointer to the value whose string key equals the <size> bytes at <data>.
+ * * Returns NULL if no value matches. Requires ds_DECLARE_MAP_BYTES().
+ *
+ *   const V*     map_find_bytes_const( const map* self, const char* data, size_t size )
+ *
+ * * Returns whether the map contains a string key equal to the <size> bytes at <data>.
+ * * Requires ds_DECLARE_MAP_BYTES().
+ *
+ *   bool         map_contains_bytes  ( const map* self, const char* data, size_t size )
+ *
  * * Sets the number of buckets in the map.
  * * This must not be less than the number of elements.
+ * * If ds_MAP_POW2 is true, <capacity> is rounded up to a power of two.
  *
  *   void         map_resize          ( map* self, size_t capacity )
  *
+ * * Shrinks the map to the fewest buckets that hold its elements under the load factor.
+ * * Skipped buckets are removed and the memory of the larger table is freed.
+ *
+ *   void         map_shrink_to_fit   ( map* self )
+ *
+ * * Removes every skipped bucket by rehashing the map in place without allocating.
+ * * The capacity does not change.
+ *
+ *   void         map_purge           ( map* self )
+ *
  * * Inserts a new key-value pair into the map.
  * * Returns whether a value was overwritten.
  *
  *   bool         map_insert          ( map* self, K key, V value )
  *
+ * * Returns a pointer to the value that matches <key>, inserting a zeroed value if none does.
+ * * This hashes and probes for <key> once. <inserted> is set to whether a value was inserted.
+ * * <inserted> may be NULL. The pointer is valid until the map is modified.
+ *
+ *   V*           map_get_or_insert   ( map* self, K key, bool* inserted )
+ *
  * * Deletes the value that matches <key>.
+ * * If ds_MAP_SHRINK_FACTOR_NUM is not 0, the map shrinks when few enough buckets are full.
  * * Returns whether <key> was found.
  *
  *   bool         map_erase           ( map* self, K key )
@@ -97,6 +210,32 @@
  *
  *   void         map_foreach_value   ( const map* self, void (*action)(V) )
  *
+ * * Returns an iterator positioned before the first pair in the map.
+ * * Inserting into the map invalidates its iterators. Erasing the current key does not,
+ * * unless ds_MAP_SHRINK_FACTOR_NUM is not 0 and the map shrinks.
+ * * If ds_MAP_INCREMENTAL_REHASH is true, map_find() also invalidates iterators.
+ *
+ *   map_iter     map_iter_begin      ( map* self )
+ *
+ * * Advances <iter> to the next pair in the map and sets <key> and <value> to point to it.
+ * * <key> or <value> may be NULL. Returns false once every pair has been visited.
+ *
+ *   bool         map_iter_next       ( map_iter* iter, const K** key, V** value )
+ *
+ * * Returns the number of full, empty, and skipped buckets in the map,
+ * * the mean, longest, and histogram of its keys' probe lengths, and the bytes it uses per pair.
+ *
+ *   ds_map_stats map_stats           ( const map* self )
+ *
+ * * Returns the number of lookups, the groups they probed, and the longest probe counted for this map type.
+ * * Nothing is counted unless ds_MAP_COUNT_PROBES is true.
+ *
+ *   ds_map_probes map_probes         ( void )
+ *
+ * * Resets the counts returned by map_probes().
+ *
+ *   void         map_reset_probes    ( void )
+ *
  * * Safely deletes a map.
  *
  *   void         map_delete          ( map* self )
@@ -107,39 +246,416 @@
 
 #include "ds_vector.h"
 
-/** Declares a named key-value hash map of the given types. */
-#define ds_DECLARE_MAP_NAMED(name, K, V, key_hasher, x_y_equals, value_deleter)\
+/** The number of keys hashed and prefetched ahead by a batched map search. */
+#define ds_MAP_BATCH 16
+
+/** Statistics about a map's buckets and probe lengths. */
+typedef struct {
+    ds_size capacity;
+    ds_size occupied;
+    ds_size empty;
+    ds_size skips;
+    double mean_probe;
+    ds_size max_probe;
+    ds_size histogram[ds_MAP_STATS_PROBES];
+    double bytes_per_entry;
+} ds_map_stats;
+
+/** Counts of the lookups made by every map of one type. */
+typedef struct {
+    ds_size lookups;
+    ds_size groups;
+    ds_size longest;
+} ds_map_probes;
+
+/** Declares a map bucket that rehashes its key when its hash is needed. */
+#define ds__DECLARE_MAP_BUCKET(name, K, V, key_hasher)\
+\
+typedef struct {\
+    K key;\
+    V value;\
+} ds__##name##_bucket;\
+\
+ds_API static inline V *ds__##name##_bucket_value(ds__##name##_bucket *bucket) {\
+    ds_assert(bucket != ds_NULL);\
+    return &bucket->value;\
+}\
+\
+ds_API static inline ds_size ds__##name##_bucket_hash(const ds__##name##_bucket *bucket) {\
+    ds_assert(bucket != ds_NULL);\
+    K key = bucket->key;\
+    return ds_hash_mix((key_hasher));\
+}\
+\
+ds_API static inline ds_bool ds__##name##_bucket_matches(const ds__##name##_bucket *bucket, ds_size hash) {\
+    (void) bucket;\
+    (void) hash;\
+    return ds_true;\
+}\
+\
+ds_API static inline void ds__##name##_bucket_store(ds__##name##_bucket *bucket, ds_size hash) {\
+    (void) bucket;\
+    (void) hash;\
+}
+
+/** Declares a map bucket that stores its key's hash. */
+#define ds__DECLARE_CACHED_MAP_BUCKET(name, K, V, key_hasher)\
 \
 typedef struct {\
     K key;\
     V value;\
-    ds_uint state;\
+    ds_size hash;\
 } ds__##name##_bucket;\
 \
+ds_API static inline V *ds__##name##_bucket_value(ds__##name##_bucket *bucket) {\
+    ds_assert(bucket != ds_NULL);\
+    return &bucket->value;\
+}\
+\
+ds_API static inline ds_size ds__##name##_bucket_hash(const ds__##name##_bucket *bucket) {\
+    ds_assert(bucket != ds_NULL);\
+    return bucket->hash;\
+}\
+\
+ds_API static inline ds_bool ds__##name##_bucket_matches(const ds__##name##_bucket *bucket, ds_size hash) {\
+    ds_assert(bucket != ds_NULL);\
+    return bucket->hash == hash;\
+}\
+\
+ds_API static inline void ds__##name##_bucket_store(ds__##name##_bucket *bucket, ds_size hash) {\
+    ds_assert(bucket != ds_NULL);\
+    bucket->hash = hash;\
+}
+
+/** Declares a set bucket whose key is also its value. */
+#define ds__DECLARE_SET_BUCKET(name, K, key_hasher)\
+\
+typedef struct {\
+    K key;\
+} ds__##name##_bucket;\
+\
+ds_API static inline K *ds__##name##_bucket_value(ds__##name##_bucket *bucket) {\
+    ds_assert(bucket != ds_NULL);\
+    return &bucket->key;\
+}\
+\
+ds_API static inline ds_size ds__##name##_bucket_hash(const ds__##name##_bucket *bucket) {\
+    ds_assert(bucket != ds_NULL);\
+    K key = bucket->key;\
+    return ds_hash_mix((key_hasher));\
+}\
+\
+ds_API static inline ds_bool ds__##name##_bucket_matches(const ds__##name##_bucket *bucket, ds_size hash) {\
+    (void) bucket;\
+    (void) hash;\
+    return ds_true;\
+}\
+\
+ds_API static inline void ds__##name##_bucket_store(ds__##name##_bucket *bucket, ds_size hash) {\
+    (void) bucket;\
+    (void) hash;\
+}
+
+/**
+ * Declares the functions of a named key-value hash map after its bucket.
+ * Ordered maps store control bytes with release ordering and load a matching one again with acquire ordering,
+ * so lock-free readers never compare a key that was not written yet. Other maps use plain loads and stores.
+ */
+#define ds__DECLARE_MAP_CORE(name, K, V, key_hasher, x_y_equals, value_deleter, ordered)\
+\
 ds_DECLARE_VECTOR_NAMED(ds__##name##_vector, ds__##name##_bucket, ds_void_deleter)\
 \
 typedef struct {\
     ds_size count;\
+    ds_size skips;\
+    ds_byte *controls;\
     ds__##name##_vector buckets;\
+    ds_byte *old_controls;\
+    ds__##name##_vector old_buckets;\
+    ds_size migrated;\
 } name;\
 \
+typedef struct {\
+    name *map;\
+    ds_bool old;\
+    ds_size position;\
+    ds_uint mask;\
+} name##_iter;\
+\
+static ds_map_probes ds__##name##_probes = {0, 0, 0};\
+\
+ds_API static inline ds_size ds__##name##_hash(K key) {\
+    return ds_hash_mix((key_hasher));\
+}\
+\
+ds_API static inline void ds__##name##_count_probe(ds_size groups) {\
+    if (ds_MAP_COUNT_PROBES) {\
+        ++ds__##name##_probes.lookups;\
+        ds__##name##_probes.groups += groups;\
+        if (groups > ds__##name##_probes.longest) {\
+            ds__##name##_probes.longest = groups;\
+        }\
+    }\
+}\
+\
+ds_API static inline ds_size ds__##name##_round(ds_size capacity) {\
+    if (capacity < ds_MAP_GROUP) {\
+        return ds_MAP_GROUP;\
+    }\
+    if (ds_MAP_POW2) {\
+        ds_size rounded = ds_MAP_GROUP;\
+        while (rounded < capacity) {\
+            ds_assert(rounded <= ds_SIZE_MAX / 2);\
+            rounded *= 2;\
+        }\
+        return rounded;\
+    }\
+    return capacity;\
+}\
+\
+ds_API static inline ds_size ds__##name##_fit(ds_size count) {\
+    ds_assert(count <= ds_SIZE_MAX / ds_MAP_LOAD_FACTOR_DEN);\
+    return ds__##name##_round((ds_MAP_LOAD_FACTOR_DEN * count + ds_MAP_LOAD_FACTOR_NUM - 1) / ds_MAP_LOAD_FACTOR_NUM);\
+}\
+\
+ds_API static inline ds_size ds__##name##_home(ds_size hash, ds_size capacity) {\
+    ds_assert(capacity >= ds_MAP_GROUP);\
+    if (ds_MAP_POW2) {\
+        ds_assert((capacity & (capacity - 1)) == 0);\
+        return hash & (capacity - 1);\
+    }\
+    return hash % capacity;\
+}\
+\
+ds_API static inline void ds__##name##_store_control(ds_byte *control_ptr, ds_byte control) {\
+    if (ordered) {\
+        ds_store_release(control_ptr, control);\
+    } else {\
+        *control_ptr = control;\
+    }\
+}\
+\
+ds_API static inline ds_bool ds__##name##_control_published(const ds_byte *controls, ds_size index, ds_byte control) {\
+    return !(ordered) || ds_load_acquire(controls + index) == control;\
+}\
+\
+ds_API static inline void ds__##name##_set_control(ds_byte *controls, ds_size capacity, ds_size index, ds_byte control) {\
+    ds_assert(controls != ds_NULL);\
+    ds_assert(index < capacity);\
+    ds__##name##_store_control(controls + index, control);\
+    if (index < ds_MAP_GROUP) {\
+        ds__##name##_store_control(controls + capacity + index, control);\
+    }\
+}\
+\
+ds_API static inline ds_uint ds__##name##_full_mask(const ds_byte *controls, ds_size capacity, ds_size position) {\
+    ds_assert(controls != ds_NULL);\
+    ds_assert(position < capacity);\
+    ds_uint mask = ~ds_group_free(controls + position) & ((1u << ds_MAP_GROUP) - 1);\
+    if (capacity - position < ds_MAP_GROUP) {\
+        mask &= (1u << (capacity - position)) - 1;\
+    }\
+    return mask;\
+}\
+\
+ds_API static inline ds_size ds__##name##_next_index(const ds_byte *controls, ds_size capacity, ds_size *position, ds_uint *mask) {\
+    ds_assert(controls != ds_NULL);\
+    ds_assert(position != ds_NULL && mask != ds_NULL);\
+    while (*mask == 0) {\
+        *position += ds_MAP_GROUP;\
+        if (*position >= capacity) {\
+            *position = capacity;\
+            return ds_NOT_FOUND;\
+        }\
+        *mask = ds__##name##_full_mask(controls, capacity, *position);\
+    }\
+    ds_size index = *position + ds_ctz(*mask);\
+    *mask &= *mask - 1;\
+    return index;\
+}\
+\
+ds_API static inline void ds__##name##_first(const name *self, ds_bool *old, ds_size *position, ds_uint *mask) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->controls != ds_NULL);\
+    *old = self->old_controls != ds_NULL;\
+    *position = 0;\
+    *mask = *old ? ds__##name##_full_mask(self->old_controls, self->old_buckets.capacity, 0) :\
+                   ds__##name##_full_mask(self->controls, self->buckets.capacity, 0);\
+}\
+\
+ds_API static inline ds__##name##_bucket *ds__##name##_next(const name *self, ds_bool *old, ds_size *position, ds_uint *mask) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(old != ds_NULL);\
+    if (*old) {\
+        ds_size index = ds__##name##_next_index(self->old_controls, self->old_buckets.capacity, position, mask);\
+        if (index != ds_NOT_FOUND) {\
+            return self->old_buckets.array + index;\
+        }\
+        *old = ds_false;\
+        *position = 0;\
+        *mask = ds__##name##_full_mask(self->controls, self->buckets.capacity, 0);\
+    }\
+    ds_size index = ds__##name##_next_index(self->controls, self->buckets.capacity, position, mask);\
+    return index != ds_NOT_FOUND ? self->buckets.array + index : ds_NULL;\
+}\
+\
+ds_API static inline ds_size ds__##name##_probe(const ds_byte *controls, const ds__##name##_bucket *array, ds_size capacity, K key, ds_size hash) {\
+    ds_assert(controls != ds_NULL);\
+    ds_assert(array != ds_NULL);\
+    ds_size position = ds__##name##_home(hash, capacity);\
+    ds_byte control = ds_map_control(hash);\
+    for (ds_size probed = 0; probed < capacity; probed += ds_MAP_GROUP) {\
+        const ds_byte *group = controls + position;\
+        for (ds_uint match = ds_group_match(group, control); match != 0; match &= match - 1) {\
+            ds_size index = position + ds_ctz(match);\
+            if (index >= capacity) {\
+                index -= capacity;\
+            }\
+            if (!ds__##name##_control_published(controls, index, control) || !ds__##name##_bucket_matches(array + index, hash)) {\
+                continue;\
+            }\
+            K x = key;\
+            K y = array[index].key;\
+            if ((x_y_equals)) {\
+                ds__##name##_count_probe(probed / ds_MAP_GROUP + 1);\
+                return index;\
+            }\
+        }\
+        if (ds_group_empty(group) != 0) {\
+            ds__##name##_count_probe(probed / ds_MAP_GROUP + 1);\
+            return ds_NOT_FOUND;\
+        }\
+        position += ds_MAP_GROUP;\
+        if (position >= capacity) {\
+            position -= capacity;\
+        }\
+    }\
+    ds__##name##_count_probe(capacity / ds_MAP_GROUP);\
+    return ds_NOT_FOUND;\
+}\
+\
+ds_API static inline ds_size ds__##name##_find_index(const name *self, K key, ds_size hash) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_probe(self->controls, self->buckets.array, self->buckets.capacity, key, hash);\
+}\
+\
+ds_API static inline ds_size ds__##name##_find_old_index(const name *self, K key, ds_size hash) {\
+    ds_assert(self != ds_NULL);\
+    if (self->old_controls == ds_NULL) {\
+        return ds_NOT_FOUND;\
+    }\
+    return ds__##name##_probe(self->old_controls, self->old_buckets.array, self->old_buckets.capacity, key, hash);\
+}\
+\
+ds_API static inline ds__##name##_bucket *ds__##name##_lookup(const name *self, K key, ds_size hash) {\
+    ds_assert(self != ds_NULL);\
+    ds_size index = ds__##name##_find_index(self, key, hash);\
+    if (index != ds_NOT_FOUND) {\
+        return self->buckets.array + index;\
+    }\
+    index = ds__##name##_find_old_index(self, key, hash);\
+    return index != ds_NOT_FOUND ? self->old_buckets.array + index : ds_NULL;\
+}\
+\
+ds_API static inline ds_size ds__##name##_free_index(const ds_byte *controls, ds_size capacity, ds_size hash) {\
+    ds_assert(controls != ds_NULL);\
+    ds_size position = ds__##name##_home(hash, capacity);\
+    ds_uint match = ds_group_free(controls + position);\
+    while (match == 0) {\
+        position += ds_MAP_GROUP;\
+        if (position >= capacity) {\
+            position -= capacity;\
+        }\
+        match = ds_group_free(controls + position);\
+    }\
+    ds_size index = position + ds_ctz(match);\
+    return index >= capacity ? index - capacity : index;\
+}\
+\
+ds_API static inline ds__##name##_bucket *ds__##name##_place(name *self, ds_size hash, ds__##name##_bucket bucket) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->count < self->buckets.capacity);\
+    ds_size index = ds__##name##_free_index(self->controls, self->buckets.capacity, hash);\
+    if (self->controls[index] == ds_BUCKET_SKIP) {\
+        --self->skips;\
+    }\
+    ds__##name##_bucket_store(&bucket, hash);\
+    self->buckets.array[index] = bucket;\
+    ds__##name##_set_control(self->controls, self->buckets.capacity, index, ds_map_control(hash));\
+    return self->buckets.array + index;\
+}\
+\
+ds_API static inline void ds__##name##_migrate(name *self, ds_size steps) {\
+    ds_assert(self != ds_NULL);\
+    if (self->old_controls == ds_NULL) {\
+        return;\
+    }\
+    ds_size capacity = self->old_buckets.capacity;\
+    for (; steps > 0 && self->migrated < capacity; --steps, ++self->migrated) {\
+        ds_size i = self->migrated;\
+        if (self->old_controls[i] & ds_BUCKET_EMPTY) {\
+            continue;\
+        }\
+        ds__##name##_bucket bucket = self->old_buckets.array[i];\
+        ds__##name##_place(self, ds__##name##_bucket_hash(&bucket), bucket);\
+        ds__##name##_set_control(self->old_controls, capacity, i, ds_BUCKET_SKIP);\
+    }\
+    if (self->migrated == capacity) {\
+        ds_free(self->old_controls);\
+        ds__##name##_vector_delete(&self->old_buckets);\
+        self->old_controls = ds_NULL;\
+        self->migrated = 0;\
+    }\
+}\
+\
+ds_API static inline ds_byte *ds__##name##_copy_controls(const ds_byte *controls, ds_size capacity) {\
+    ds_assert(controls != ds_NULL);\
+    ds_byte *copy = (ds_byte *) ds_malloc(capacity + ds_MAP_GROUP);\
+    ds_assert(copy != ds_NULL);\
+    ds_memcpy(copy, controls, capacity + ds_MAP_GROUP);\
+    return copy;\
+}\
+\
+ds_API static inline ds__##name##_vector ds__##name##_copy_buckets(const ds__##name##_vector *buckets) {\
+    ds_assert(buckets != ds_NULL);\
+    ds__##name##_vector copy = ds__##name##_vector_copy(buckets);\
+    ds_memcpy(copy.array, buckets->array, sizeof(ds__##name##_bucket) * buckets->capacity);\
+    return copy;\
+}\
+\
 ds_API static inline name name##_new(ds_size capacity) {\
     ds_assert(capacity > 0);\
+    capacity = ds__##name##_round(capacity);\
     name self = (name) {\
         0,\
+        0,\
+        (ds_byte *) ds_malloc(capacity + ds_MAP_GROUP),\
         ds__##name##_vector_new(capacity),\
+        ds_NULL,\
+        {0},\
+        0,\
     };\
-    ds_memset(self.buckets.array, 0, sizeof(ds__##name##_bucket) * capacity);\
+    ds_assert(self.controls != ds_NULL);\
+    ds_memset(self.controls, ds_BUCKET_EMPTY, capacity + ds_MAP_GROUP);\
     return self;\
 }\
 \
 ds_API static inline name name##_copy(const name *map) {\
     ds_assert(map != ds_NULL);\
+    ds_assert(map->controls != ds_NULL);\
     name self = (name) {\
         map->count,\
-        ds__##name##_vector_copy(&map->buckets),\
+        map->skips,\
+        ds__##name##_copy_controls(map->controls, map->buckets.capacity),\
+        ds__##name##_copy_buckets(&map->buckets),\
+        ds_NULL,\
+        {0},\
+        map->migrated,\
     };\
-    ds_memcpy(self.buckets.array, map->buckets.array, sizeof(ds__##name##_bucket) * map->buckets.capacity);\
+    if (map->old_controls != ds_NULL) {\
+        self.old_controls = ds__##name##_copy_controls(map->old_controls, map->old_buckets.capacity);\
+        self.old_buckets = ds__##name##_copy_buckets(&map->old_buckets);\
+    }\
     return self;\
 }\
 \
@@ -158,56 +674,59 @@ ds_API static inline ds_bool name##_empty(const name *self) {\
     return self->count == 0;\
 }\
 \
-ds_API static inline V *name##_find(name *self, K key) {\
+ds_API static inline ds_size name##_hash(K key) {\
+    return ds__##name##_hash(key);\
+}\
+\
+ds_API static inline V *name##_find_hashed(name *self, K key, ds_size hash) {\
     ds_assert(self != ds_NULL);\
-    ds_assert(self->buckets.array != ds_NULL);\
-    ds_size hash = (key_hasher);\
-    ds_size capacity = self->buckets.capacity;\
-    hash %= capacity;\
-    ds_size remaining = self->count;\
-    for (ds_size i = 0; remaining > 0 && i < capacity; ++i) {\
-        ds__##name##_bucket *bucket = self->buckets.array + ((hash + i) % capacity);\
-        if (bucket->state == ds_BUCKET_EMPTY) {\
-            return ds_NULL;\
-        }\
-        if (bucket->state == ds_BUCKET_SKIP) {\
-            continue;\
-        }\
-        K x = key;\
-        K y = bucket->key;\
-        if ((x_y_equals)) {\
-            return &bucket->value;\
+    ds_assert(hash == ds__##name##_hash(key));\
+    ds__##name##_migrate(self, ds_MAP_REHASH_STEP);\
+    ds__##name##_bucket *bucket = ds__##name##_lookup(self, key, hash);\
+    return bucket != ds_NULL ? ds__##name##_bucket_value(bucket) : ds_NULL;\
+}\
+\
+ds_API static inline void ds__##name##_prefetch(const name *self, ds_size hash) {\
+    ds_assert(self != ds_NULL);\
+    ds_size home = ds__##name##_home(hash, self->buckets.capacity);\
+    ds_prefetch(self->controls + home);\
+    ds_prefetch(self->buckets.array + home);\
+}\
+\
+ds_API static inline ds_size name##_find_batch(name *self, const K *keys, ds_size count, V **values) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(count == 0 || (keys != ds_NULL && values != ds_NULL));\
+    ds__##name##_migrate(self, ds_MAP_REHASH_STEP);\
+    ds_size hashes[ds_MAP_BATCH];\
+    for (ds_size i = 0; i < count && i < ds_MAP_BATCH; ++i) {\
+        hashes[i] = ds__##name##_hash(keys[i]);\
+        ds__##name##_prefetch(self, hashes[i]);\
+    }\
+    ds_size found = 0;\
+    for (ds_size i = 0; i < count; ++i) {\
+        ds_size hash = hashes[i % ds_MAP_BATCH];\
+        if (i + ds_MAP_BATCH < count) {\
+            hashes[i % ds_MAP_BATCH] = ds__##name##_hash(keys[i + ds_MAP_BATCH]);\
+            ds__##name##_prefetch(self, hashes[i % ds_MAP_BATCH]);\
         }\
-        --remaining;\
+        ds__##name##_bucket *bucket = ds__##name##_lookup(self, keys[i], hash);\
+        values[i] = bucket != ds_NULL ? ds__##name##_bucket_value(bucket) : ds_NULL;\
+        found += bucket != ds_NULL;\
     }\
-    ds_assert(remaining == 0);\
-    return ds_NULL;\
+    return found;\
+}\
+\
+ds_API static inline V *name##_find(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_migrate(self, ds_MAP_REHASH_STEP);\
+    ds__##name##_bucket *bucket = ds__##name##_lookup(self, key, ds__##name##_hash(key));\
+    return bucket != ds_NULL ? ds__##name##_bucket_value(bucket) : ds_NULL;\
 }\
 \
 ds_API static inline const V *name##_find_const(const name *self, K key) {\
     ds_assert(self != ds_NULL);\
-    ds_assert(self->buckets.array != ds_NULL);\
-    ds_size hash = (key_hasher);\
-    ds_size capacity = self->buckets.capacity;\
-    hash %= capacity;\
-    ds_size remaining = self->count;\
-    for (ds_size i = 0; remaining > 0 && i < capacity; ++i) {\
-        const ds__##name##_bucket *bucket = self->buckets.array + ((hash + i) % capacity);\
-        if (bucket->state == ds_BUCKET_EMPTY) {\
-            return ds_NULL;\
-        }\
-        if (bucket->state == ds_BUCKET_SKIP) {\
-            continue;\
-        }\
-        K x = key;\
-        K y = bucket->key;\
-        if ((x_y_equals)) {\
-            return &bucket->value;\
-        }\
-        --remaining;\
-    }\
-    ds_assert(remaining == 0);\
-    return ds_NULL;\
+    ds__##name##_bucket *bucket = ds__##name##_lookup(self, key, ds__##name##_hash(key));\
+    return bucket != ds_NULL ? ds__##name##_bucket_value(bucket) : ds_NULL;\
 }\
 \
 ds_API static inline ds_bool name##_contains(const name *self, K key) {\
@@ -218,185 +737,427 @@ ds_API static inline ds_bool name##_contains(const name *self, K key) {\
 ds_API static inline void name##_resize(name *self, ds_size capacity) {\
     ds_assert(self != ds_NULL);\
     ds_assert(capacity >= self->count);\
-    if (capacity == self->count) {\
+    ds_assert(self->controls != ds_NULL);\
+    ds_assert(self->buckets.array != ds_NULL);\
+    name map = name##_new(ds__##name##_round(capacity));\
+    ds_bool old;\
+    ds_size position;\
+    ds_uint mask;\
+    ds__##name##_first(self, &old, &position, &mask);\
+    for (ds__##name##_bucket *bucket = ds__##name##_next(self, &old, &position, &mask);\
+         bucket != ds_NULL;\
+         bucket = ds__##name##_next(self, &old, &position, &mask)) {\
+        ds__##name##_place(&map, ds__##name##_bucket_hash(bucket), *bucket);\
+        ++map.count;\
+    }\
+    ds_assert(map.count == self->count);\
+    if (self->old_controls != ds_NULL) {\
+        ds_free(self->old_controls);\
+        ds__##name##_vector_delete(&self->old_buckets);\
+    }\
+    ds_free(self->controls);\
+    ds__##name##_vector_delete(&self->buckets);\
+    *self = map;\
+}\
+\
+ds_API static inline void ds__##name##_rehash(name *self, ds_size capacity) {\
+    ds_assert(self != ds_NULL);\
+    if (!ds_MAP_INCREMENTAL_REHASH) {\
+        name##_resize(self, capacity);\
         return;\
     }\
-    ds_assert(self->buckets.array != ds_NULL);\
-    ds__##name##_bucket *array = (ds__##name##_bucket *) ds_calloc(capacity, sizeof(ds__##name##_bucket));\
-    ds_assert(array != ds_NULL);\
-    ds_size remaining = self->count;\
-    for (ds_size i = 0; remaining > 0 && i < self->buckets.capacity; ++i) {\
-        ds__##name##_bucket *bucket = self->buckets.array + i;\
-        if (bucket->state != ds_BUCKET_OCCUPIED) {\
+    ds__##name##_migrate(self, ds_SIZE_MAX);\
+    name map = name##_new(capacity);\
+    self->old_controls = self->controls;\
+    self->old_buckets = self->buckets;\
+    self->migrated = 0;\
+    self->controls = map.controls;\
+    self->buckets = map.buckets;\
+    self->skips = 0;\
+}\
+\
+ds_API static inline void name##_shrink_to_fit(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_size capacity = ds__##name##_fit(self->count);\
+    if (capacity < self->buckets.capacity || self->old_controls != ds_NULL) {\
+        name##_resize(self, capacity < self->buckets.capacity ? capacity : self->buckets.capacity);\
+    }\
+}\
+\
+ds_API static inline void name##_purge(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->controls != ds_NULL);\
+    ds__##name##_migrate(self, ds_SIZE_MAX);\
+    ds_size capacity = self->buckets.capacity;\
+    ds_byte *controls = self->controls;\
+    ds__##name##_bucket *array = self->buckets.array;\
+    for (ds_size i = 0; i < capacity; ++i) {\
+        controls[i] = controls[i] == ds_BUCKET_SKIP ? ds_BUCKET_EMPTY :\
+                      (controls[i] & ds_BUCKET_EMPTY) ? controls[i] : ds_BUCKET_SKIP;\
+    }\
+    ds_memcpy(controls + capacity, controls, ds_MAP_GROUP);\
+    for (ds_size i = 0; i < capacity; ++i) {\
+        if (controls[i] != ds_BUCKET_SKIP) {\
             continue;\
         }\
-        K key = bucket->key;\
-        ds_size hash = (key_hasher);\
-        hash %= capacity;\
-        for (ds_size j = 0; j < capacity; ++j) {\
-            ds__##name##_bucket *target = array + ((hash + j) % capacity);\
-            if (target->state == ds_BUCKET_OCCUPIED) {\
-                continue;\
-            }\
-            *target = *bucket;\
-            break;\
+        ds_size hash = ds__##name##_bucket_hash(array + i);\
+        ds_size home = ds__##name##_home(hash, capacity);\
+        ds_size target = ds__##name##_free_index(controls, capacity, hash);\
+        if ((i >= home ? i - home : i + capacity - home) / ds_MAP_GROUP ==\
+            (target >= home ? target - home : target + capacity - home) / ds_MAP_GROUP) {\
+            ds__##name##_set_control(controls, capacity, i, ds_map_control(hash));\
+            continue;\
+        }\
+        ds_bool pending = controls[target] == ds_BUCKET_SKIP;\
+        ds__##name##_set_control(controls, capacity, target, ds_map_control(hash));\
+        ds__##name##_bucket bucket = array[target];\
+        array[target] = array[i];\
+        if (pending) {\
+            array[i] = bucket;\
+            --i;\
+        } else {\
+            ds__##name##_set_control(controls, capacity, i, ds_BUCKET_EMPTY);\
         }\
-        --remaining;\
     }\
-    ds_assert(remaining == 0);\
-    self->buckets.capacity = capacity;\
-    ds_free(self->buckets.array);\
-    self->buckets.array = array;\
+    self->skips = 0;\
 }\
 \
-ds_API static inline ds_bool name##_insert(name *self, K key, V value) {\
+ds_API static inline ds__##name##_bucket *ds__##name##_emplace(name *self, K key, ds_bool *found) {\
     ds_assert(self != ds_NULL);\
+    ds_assert(found != ds_NULL);\
     ds_assert(self->buckets.array != ds_NULL);\
-    if (ds_MAP_LOAD_FACTOR_DEN * (self->count + 1) > ds_MAP_LOAD_FACTOR_NUM * self->buckets.capacity) {\
-        ds_size new_capacity = ds_VECTOR_EXPANSION * self->buckets.capacity;\
-        ds_assert(new_capacity > self->buckets.capacity);\
-        name##_resize(self, new_capacity);\
-    }\
-    ds__##name##_bucket new_bucket = (ds__##name##_bucket) {\
-        key,\
-        value,\
-        ds_BUCKET_OCCUPIED,\
-    };\
-    ds_size hash = (key_hasher);\
-    while (ds_true) {\
-        ds_size capacity = self->buckets.capacity;\
-        hash %= capacity;\
-        ds__##name##_bucket *target = ds_NULL;\
-        for (ds_size i = 0; i < capacity; ++i) {\
-            ds__##name##_bucket *bucket = self->buckets.array + ((hash + i) % capacity);\
-            if (bucket->state == ds_BUCKET_EMPTY) {\
-                ++self->count;\
-                if (target == ds_NULL) {\
-                    target = bucket;\
-                }\
-                *target = new_bucket;\
-                return ds_false;\
-            }\
-            if (bucket->state == ds_BUCKET_SKIP) {\
-                if (target == ds_NULL) {\
-                    target = bucket;\
-                }\
-                continue;\
-            }\
-            K x = key;\
-            K y = bucket->key;\
-            if ((x_y_equals)) {\
-                value_deleter(&bucket->value);\
-                bucket->value = value;\
-                return ds_true;\
-            }\
+    ds_size hash = ds__##name##_hash(key);\
+    ds__##name##_bucket *bucket = ds__##name##_lookup(self, key, hash);\
+    if (bucket != ds_NULL) {\
+        *found = ds_true;\
+        return bucket;\
+    }\
+    if (ds_MAP_LOAD_FACTOR_DEN * (self->count + self->skips + 1) > ds_MAP_LOAD_FACTOR_NUM * self->buckets.capacity) {\
+        ds_size new_capacity = self->buckets.capacity;\
+        if (2 * ds_MAP_LOAD_FACTOR_DEN * (self->count + 1) > ds_MAP_LOAD_FACTOR_NUM * self->buckets.capacity) {\
+            new_capacity = ds_VECTOR_EXPANSION * self->buckets.capacity;\
+            ds_assert(new_capacity > self->buckets.capacity);\
         }\
-        ds_size new_capacity = ds_VECTOR_EXPANSION * self->buckets.capacity;\
-        ds_assert(new_capacity > self->buckets.capacity);\
-        name##_resize(self, new_capacity);\
+        ds__##name##_rehash(self, new_capacity);\
     }\
+    ds__##name##_migrate(self, ds_MAP_REHASH_STEP);\
+    ds__##name##_bucket empty = {0};\
+    empty.key = key;\
+    bucket = ds__##name##_place(self, hash, empty);\
+    ++self->count;\
+    *found = ds_false;\
+    return bucket;\
 }\
 \
-ds_API static inline ds_bool name##_erase(name *self, K key) {\
+ds_API static inline ds_bool name##_insert(name *self, K key, V value) {\
     ds_assert(self != ds_NULL);\
-    ds_assert(self->buckets.array != ds_NULL);\
-    ds_size hash = (key_hasher);\
-    ds_size capacity = self->buckets.capacity;\
-    hash %= capacity;\
-    ds_size remaining = self->count;\
-    for (ds_size i = 0; remaining > 0 && i < capacity; ++i) {\
-        ds__##name##_bucket *bucket = self->buckets.array + ((hash + i) % capacity);\
-        if (bucket->state == ds_BUCKET_EMPTY) {\
+    ds_bool found;\
+    ds__##name##_bucket *bucket = ds__##name##_emplace(self, key, &found);\
+    if (found) {\
+        value_deleter(ds__##name##_bucket_value(bucket));\
+    }\
+    *ds__##name##_bucket_value(bucket) = value;\
+    return found;\
+}\
+\
+ds_API static inline V *name##_get_or_insert(name *self, K key, ds_bool *inserted) {\
+    ds_assert(self != ds_NULL);\
+    ds_bool found;\
+    ds__##name##_bucket *bucket = ds__##name##_emplace(self, key, &found);\
+    if (inserted != ds_NULL) {\
+        *inserted = !found;\
+    }\
+    return ds__##name##_bucket_value(bucket);\
+}\
+\
+ds_API static inline ds_bool ds__##name##_remove(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_size hash = ds__##name##_hash(key);\
+    ds_size index = ds__##name##_find_index(self, key, hash);\
+    if (index == ds_NOT_FOUND) {\
+        index = ds__##name##_find_old_index(self, key, hash);\
+        if (index == ds_NOT_FOUND) {\
             return ds_false;\
         }\
-        if (bucket->state == ds_BUCKET_SKIP) {\
-            continue;\
-        }\
-        K x = key;\
-        K y = bucket->key;\
-        if ((x_y_equals)) {\
-            --self->count;\
-            value_deleter(&bucket->value);\
-            bucket->state = ds_BUCKET_SKIP;\
-            return ds_true;\
+        --self->count;\
+        value_deleter(ds__##name##_bucket_value(self->old_buckets.array + index));\
+        ds__##name##_set_control(self->old_controls, self->old_buckets.capacity, index, ds_BUCKET_SKIP);\
+        return ds_true;\
+    }\
+    --self->count;\
+    value_deleter(ds__##name##_bucket_value(self->buckets.array + index));\
+    ds_size capacity = self->buckets.capacity;\
+    ds_size before = index >= ds_MAP_GROUP ? index - ds_MAP_GROUP : index + capacity - ds_MAP_GROUP;\
+    ds_uint empty_before = ds_group_empty(self->controls + before);\
+    ds_uint empty_after = ds_group_empty(self->controls + index);\
+    if (empty_before != 0 && empty_after != 0 &&\
+        ds_ctz(empty_after) + ds_clz(empty_before) - (sizeof(ds_size) * 8 - ds_MAP_GROUP) < ds_MAP_GROUP) {\
+        ds__##name##_set_control(self->controls, capacity, index, ds_BUCKET_EMPTY);\
+    } else {\
+        ds__##name##_set_control(self->controls, capacity, index, ds_BUCKET_SKIP);\
+        ++self->skips;\
+    }\
+    return ds_true;\
+}\
+\
+ds_API static inline ds_bool name##_erase(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    if (!ds__##name##_remove(self, key)) {\
+        return ds_false;\
+    }\
+    if (ds_MAP_SHRINK_FACTOR_DEN * self->count < ds_MAP_SHRINK_FACTOR_NUM * self->buckets.capacity) {\
+        ds_size capacity = ds__##name##_fit(2 * self->count);\
+        if (capacity < self->buckets.capacity) {\
+            name##_resize(self, capacity);\
         }\
-        --remaining;\
     }\
-    ds_assert(remaining == 0);\
-    return ds_false;\
+    return ds_true;\
 }\
 \
 ds_API static inline void name##_clear(name *self) {\
     ds_assert(self != ds_NULL);\
+    ds_assert(self->controls != ds_NULL);\
     ds_assert(self->buckets.array != ds_NULL);\
-    for (ds_size i = 0; self->count > 0 && i < self->buckets.capacity; ++i) {\
-        ds__##name##_bucket *bucket = self->buckets.array + i;\
-        if (bucket->state != ds_BUCKET_OCCUPIED) {\
-            continue;\
-        }\
-        --self->count;\
-        value_deleter(&bucket->value);\
+    ds_bool old;\
+    ds_size position;\
+    ds_uint mask;\
+    ds__##name##_first(self, &old, &position, &mask);\
+    for (ds__##name##_bucket *bucket = ds__##name##_next(self, &old, &position, &mask);\
+         bucket != ds_NULL;\
+         bucket = ds__##name##_next(self, &old, &position, &mask)) {\
+        value_deleter(ds__##name##_bucket_value(bucket));\
+    }\
+    if (self->old_controls != ds_NULL) {\
+        ds_free(self->old_controls);\
+        ds__##name##_vector_delete(&self->old_buckets);\
+        self->old_controls = ds_NULL;\
+        self->migrated = 0;\
     }\
-    ds_memset(self->buckets.array, 0, sizeof(ds__##name##_bucket) * self->buckets.capacity);\
+    ds_memset(self->controls, ds_BUCKET_EMPTY, self->buckets.capacity + ds_MAP_GROUP);\
+    self->count = 0;\
+    self->skips = 0;\
 }\
 \
 ds_API static inline void name##_foreach(const name *self, void(*action)(K, V)) {\
     ds_assert(self != ds_NULL);\
     ds_assert(action != ds_NULL);\
-    ds_assert(self->buckets.array != ds_NULL);\
-    ds_size remaining = self->count;\
-    for (ds_size i = 0; remaining > 0 && i < self->buckets.capacity; ++i) {\
-        const ds__##name##_bucket *bucket = self->buckets.array + i;\
-        if (bucket->state != ds_BUCKET_OCCUPIED) {\
-            continue;\
-        }\
-        action(bucket->key, bucket->value);\
-        --remaining;\
+    ds_bool old;\
+    ds_size position;\
+    ds_uint mask;\
+    ds__##name##_first(self, &old, &position, &mask);\
+    for (ds__##name##_bucket *bucket = ds__##name##_next(self, &old, &position, &mask);\
+         bucket != ds_NULL;\
+         bucket = ds__##name##_next(self, &old, &position, &mask)) {\
+        action(bucket->key, *ds__##name##_bucket_value(bucket));\
     }\
-    ds_assert(remaining == 0);\
 }\
 \
 ds_API static inline void name##_foreach_key(const name *self, void(*action)(K)) {\
     ds_assert(self != ds_NULL);\
     ds_assert(action != ds_NULL);\
-    ds_assert(self->buckets.array != ds_NULL);\
-    ds_size remaining = self->count;\
-    for (ds_size i = 0; remaining > 0 && i < self->buckets.capacity; ++i) {\
-        const ds__##name##_bucket *bucket = self->buckets.array + i;\
-        if (bucket->state != ds_BUCKET_OCCUPIED) {\
-            continue;\
-        }\
+    ds_bool old;\
+    ds_size position;\
+    ds_uint mask;\
+    ds__##name##_first(self, &old, &position, &mask);\
+    for (const ds__##name##_bucket *bucket = ds__##name##_next(self, &old, &position, &mask);\
+         bucket != ds_NULL;\
+         bucket = ds__##name##_next(self, &old, &position, &mask)) {\
         action(bucket->key);\
-        --remaining;\
     }\
-    ds_assert(remaining == 0);\
 }\
 \
 ds_API static inline void name##_foreach_value(const name *self, void(*action)(V)) {\
     ds_assert(self != ds_NULL);\
     ds_assert(action != ds_NULL);\
-    ds_assert(self->buckets.array != ds_NULL);\
-    ds_size remaining = self->count;\
-    for (ds_size i = 0; remaining > 0 && i < self->buckets.capacity; ++i) {\
-        const ds__##name##_bucket *bucket = self->buckets.array + i;\
-        if (bucket->state != ds_BUCKET_OCCUPIED) {\
+    ds_bool old;\
+    ds_size position;\
+    ds_uint mask;\
+    ds__##name##_first(self, &old, &position, &mask);\
+    for (ds__##name##_bucket *bucket = ds__##name##_next(self, &old, &position, &mask);\
+         bucket != ds_NULL;\
+         bucket = ds__##name##_next(self, &old, &position, &mask)) {\
+        action(*ds__##name##_bucket_value(bucket));\
+    }\
+}\
+\
+ds_API static inline name##_iter name##_iter_begin(name *self) {\
+    ds_assert(self != ds_NULL);\
+    name##_iter iter;\
+    iter.map = self;\
+    ds__##name##_first(self, &iter.old, &iter.position, &iter.mask);\
+    return iter;\
+}\
+\
+ds_API static inline ds_bool name##_iter_next(name##_iter *iter, const K **key, V **value) {\
+    ds_assert(iter != ds_NULL);\
+    ds_assert(iter->map != ds_NULL);\
+    ds__##name##_bucket *bucket = ds__##name##_next(iter->map, &iter->old, &iter->position, &iter->mask);\
+    if (bucket == ds_NULL) {\
+        return ds_false;\
+    }\
+    if (key != ds_NULL) {\
+        *key = &bucket->key;\
+    }\
+    if (value != ds_NULL) {\
+        *value = ds__##name##_bucket_value(bucket);\
+    }\
+    return ds_true;\
+}\
+\
+ds_API static inline void ds__##name##_table_stats(const ds_byte *controls, const ds__##name##_bucket *array, ds_size capacity,\
+                                                   ds_map_stats *stats, ds_size *total) {\
+    ds_assert(controls != ds_NULL);\
+    ds_assert(stats != ds_NULL && total != ds_NULL);\
+    stats->capacity += capacity;\
+    for (ds_size i = 0; i < capacity; ++i) {\
+        if (controls[i] == ds_BUCKET_SKIP) {\
+            ++stats->skips;\
             continue;\
         }\
-        action(bucket->value);\
-        --remaining;\
+        if (controls[i] & ds_BUCKET_EMPTY) {\
+            ++stats->empty;\
+            continue;\
+        }\
+        ds_size home = ds__##name##_home(ds__##name##_bucket_hash(array + i), capacity);\
+        ds_size groups = (i >= home ? i - home : i + capacity - home) / ds_MAP_GROUP + 1;\
+        ++stats->occupied;\
+        *total += groups;\
+        if (groups > stats->max_probe) {\
+            stats->max_probe = groups;\
+        }\
+        ++stats->histogram[groups < ds_MAP_STATS_PROBES ? groups - 1 : ds_MAP_STATS_PROBES - 1];\
     }\
-    ds_assert(remaining == 0);\
+}\
+\
+ds_API static inline ds_map_stats name##_stats(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->controls != ds_NULL);\
+    ds_map_stats stats;\
+    ds_memset(&stats, 0, sizeof(stats));\
+    ds_size total = 0;\
+    ds__##name##_table_stats(self->controls, self->buckets.array, self->buckets.capacity, &stats, &total);\
+    if (self->old_controls != ds_NULL) {\
+        ds__##name##_table_stats(self->old_controls, self->old_buckets.array, self->old_buckets.capacity, &stats, &total);\
+    }\
+    ds_assert(stats.occupied == self->count);\
+    if (stats.occupied > 0) {\
+        ds_size bytes = (sizeof(ds__##name##_bucket) + 1) * stats.capacity + ds_MAP_GROUP;\
+        if (self->old_controls != ds_NULL) {\
+            bytes += ds_MAP_GROUP;\
+        }\
+        stats.mean_probe = (double) total / (double) stats.occupied;\
+        stats.bytes_per_entry = (double) bytes / (double) stats.occupied;\
+    }\
+    return stats;\
+}\
+\
+ds_API static inline ds_map_probes name##_probes(void) {\
+    return ds__##name##_probes;\
+}\
+\
+ds_API static inline void name##_reset_probes(void) {\
+    ds__##name##_probes = (ds_map_probes) {0, 0, 0};\
 }\
 \
 ds_API static inline void name##_delete(name *self) {\
     ds_assert(self != ds_NULL);\
     name##_clear(self);\
+    ds_free(self->controls);\
     ds__##name##_vector_delete(&self->buckets);\
     *self = (name) {0};\
 }
 
+/** Declares a named key-value hash map of the given types. */
+#define ds_DECLARE_MAP_NAMED(name, K, V, key_hasher, x_y_equals, value_deleter)\
+        ds__DECLARE_MAP_BUCKET(name, K, V, key_hasher)\
+        ds__DECLARE_MAP_CORE(name, K, V, key_hasher, x_y_equals, value_deleter, 0)
+
+/** Declares a named key-value hash map of the given types that stores each key's hash. */
+#define ds_DECLARE_CACHED_MAP_NAMED(name, K, V, key_hasher, x_y_equals, value_deleter)\
+        ds__DECLARE_CACHED_MAP_BUCKET(name, K, V, key_hasher)\
+        ds__DECLARE_MAP_CORE(name, K, V, key_hasher, x_y_equals, value_deleter, 0)
+
+/** Declares a named key-value hash map whose control bytes are ordered for lock-free readers. */
+#define ds__DECLARE_ORDERED_MAP_NAMED(name, K, V, key_hasher, x_y_equals, value_deleter)\
+        ds__DECLARE_MAP_BUCKET(name, K, V, key_hasher)\
+        ds__DECLARE_MAP_CORE(name, K, V, key_hasher, x_y_equals, value_deleter, 1)
+
 /** Declares a key-value hash map of the given types. */
 #define ds_DECLARE_MAP(K, V, key_hasher, x_y_equals, value_deleter)\
         ds_DECLARE_MAP_NAMED(K##_##V##_map, K, V, key_hasher, x_y_equals, value_deleter)
 
+/** Declares a key-value hash map of the given types that stores each key's hash. */
+#define ds_DECLARE_CACHED_MAP(K, V, key_hasher, x_y_equals, value_deleter)\
+        ds_DECLARE_CACHED_MAP_NAMED(K##_##V##_map, K, V, key_hasher, x_y_equals, value_deleter)
+
+/** Declares functions that find string keys in a named map by a pointer and length. */
+#define ds_DECLARE_MAP_BYTES(name, V, bytes_hasher, key_bytes_equals)\
+\
+ds_API static inline ds_size ds__##name##_probe_bytes(const ds_byte *controls, const ds__##name##_bucket *array, ds_size capacity, const char *data, ds_size size, ds_size hash) {\
+    ds_assert(controls != ds_NULL);\
+    ds_assert(array != ds_NULL);\
+    ds_size position = ds__##name##_home(hash, capacity);\
+    ds_byte control = ds_map_control(hash);\
+    for (ds_size probed = 0; probed < capacity; probed += ds_MAP_GROUP) {\
+        const ds_byte *group = controls + position;\
+        for (ds_uint match = ds_group_match(group, control); match != 0; match &= match - 1) {\
+            ds_size index = position + ds_ctz(match);\
+            if (index >= capacity) {\
+                index -= capacity;\
+            }\
+            if (!ds__##name##_control_published(controls, index, control) || !ds__##name##_bucket_matches(array + index, hash)) {\
+                continue;\
+            }\
+            const char *key = array[index].key;\
+            if ((key_bytes_equals)) {\
+                ds__##name##_count_probe(probed / ds_MAP_GROUP + 1);\
+                return index;\
+            }\
+        }\
+        if (ds_group_empty(group) != 0) {\
+            ds__##name##_count_probe(probed / ds_MAP_GROUP + 1);\
+            return ds_NOT_FOUND;\
+        }\
+        position += ds_MAP_GROUP;\
+        if (position >= capacity) {\
+            position -= capacity;\
+        }\
+    }\
+    ds__##name##_count_probe(capacity / ds_MAP_GROUP);\
+    return ds_NOT_FOUND;\
+}\
+\
+ds_API static inline ds__##name##_bucket *ds__##name##_lookup_bytes(const name *self, const char *data, ds_size size) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->controls != ds_NULL);\
+    ds_assert(data != ds_NULL || size == 0);\
+    ds_size hash = ds_hash_mix((bytes_hasher));\
+    ds_size index = ds__##name##_probe_bytes(self->controls, self->buckets.array, self->buckets.capacity, data, size, hash);\
+    if (index != ds_NOT_FOUND) {\
+        return self->buckets.array + index;\
+    }\
+    if (self->old_controls == ds_NULL) {\
+        return ds_NULL;\
+    }\
+    index = ds__##name##_probe_bytes(self->old_controls, self->old_buckets.array, self->old_buckets.capacity, data, size, hash);\
+    return index != ds_NOT_FOUND ? self->old_buckets.array + index : ds_NULL;\
+}\
+\
+ds_API static inline V *name##_find_bytes(name *self, const char *data, ds_size size) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_bucket *bucket = ds__##name##_lookup_bytes(self, data, size);\
+    return bucket != ds_NULL ? ds__##name##_bucket_value(bucket) : ds_NULL;\
+}\
+\
+ds_API static inline const V *name##_find_bytes_const(const name *self, const char *data, ds_size size) {\
+    ds_assert(self != ds_NULL);\
+    ds__##name##_bucket *bucket = ds__##name##_lookup_bytes(self, data, size);\
+    return bucket != ds_NULL ? ds__##name##_bucket_value(bucket) : ds_NULL;\
+}\
+\
+ds_API static inline ds_bool name##_contains_bytes(const name *self, const char *data, ds_size size) {\
+    ds_assert(self != ds_NULL);\
+    return ds__##name##_lookup_bytes(self, data, size) != ds_NULL;\
+}
+
 #endif // DS_MAP_H
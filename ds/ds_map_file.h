@@ -0,0 +1,246 @@
+// .h
+// ds.h Memory-Mapped Hash Map Files
+// by Kyle Furey
+
+/**
+ * ds_map_file.h
+ *
+ * ds_DECLARE_MAP_FILE(
+ *      name,           - The name of a map declared with ds_DECLARE_MAP_NAMED() or ds_DECLARE_CACHED_MAP_NAMED().
+ *
+ *      K,              - The map's key type. It must be trivially copyable and must not point to memory.
+ *
+ *      V,              - The map's value type. It must be trivially copyable and must not point to memory.
+ * )
+ *
+ * This adds functions that save a ds_map.h map to a file and open that file again without rebuilding it.
+ * The file stores the map's control bytes and buckets exactly as they sit in memory.
+ * Opening a file maps it into memory read-only, so it is ready at once and pages load as they are probed.
+ *
+ * Files start with a versioned header that records the key, value, and bucket sizes and the map settings.
+ * A file only opens with the same map declaration, settings, and byte order it was saved with.
+ * key_hasher must give the same hash for the same key in every process, so pointer keys cannot be saved.
+ *
+ * A mapped map may only be used with functions that do not change it, such as map_find_const(), map_contains(), and map_foreach().
+ * map_copy() returns a normal map from a mapped one that may then be changed.
+ *
+ * This header requires POSIX mmap(), so ds.h does not include it.
+ *
+ * * Writes <self> to the file at <path>, replacing it.
+ * * Returns whether the whole map was written.
+ *
+ *   bool         map_save            ( const map* self, const char* path )
+ *
+ * * Maps the file at <path> into memory and sets <self> to the map stored in it.
+ * * Returns whether the file was a valid map file for this map. <self> is not changed if it was not.
+ * * This map must be closed with map_close_mmap() instead of map_delete().
+ *
+ *   bool         map_open_mmap       ( map* self, const char* path )
+ *
+ * * Unmaps a map opened with map_open_mmap().
+ *
+ *   void         map_close_mmap      ( map* self )
+ */
+
+#ifndef DS_MAP_FILE_H
+#define DS_MAP_FILE_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ds_map.h"
+
+/** The version of the map file format. */
+#define ds__MAP_FILE_VERSION 1
+
+/** Marks the byte order a map file was saved with. */
+#define ds__MAP_FILE_ENDIAN 0x01020304u
+
+/** Aligns an offset in a map file to a cache line. */
+#define ds__MAP_FILE_ALIGN(offset) ds_ARENA_ALIGN((ds_size) (offset), (ds_size) ds_CACHE_LINE)
+
+/** Hints that a mapped map file will be probed at random. */
+#ifdef POSIX_MADV_RANDOM
+#define ds__map_file_advise(base, size) posix_madvise(base, size, POSIX_MADV_RANDOM)
+#else
+#define ds__map_file_advise(base, size) ((void) (base), (void) (size))
+#endif
+
+/** The number of buckets written to a map file at once. */
+#define ds__MAP_FILE_CHUNK 256
+
+/** The header at the start of a map file. */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint64_t size_bytes;
+    uint64_t group;
+    uint64_t pow2;
+    uint64_t key_size;
+    uint64_t value_size;
+    uint64_t bucket_size;
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t skips;
+    uint64_t controls_offset;
+    uint64_t buckets_offset;
+    uint64_t file_size;
+} ds__map_file_header;
+
+/** The magic bytes at the start of a map file. */
+static const char ds__map_file_magic[8] = {'d', 's', '.', 'm', 'a', 'p', '\0', '\0'};
+
+/** Writes <size> zero bytes to a file. */
+ds_API static inline ds_bool ds__map_file_pad(FILE *file, ds_size size) {
+    ds_assert(file != ds_NULL);
+    static const ds_byte zeros[ds_CACHE_LINE] = {0};
+    ds_assert(size <= ds_CACHE_LINE);
+    return fwrite(zeros, 1, size, file) == size;
+}
+
+/** Declares functions that save and memory-map files for a named map. */
+#define ds_DECLARE_MAP_FILE(name, K, V)\
+\
+ds_API static inline ds__map_file_header ds__##name##_file_header(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_size capacity = self->buckets.capacity;\
+    ds_size controls_offset = ds__MAP_FILE_ALIGN(sizeof(ds__map_file_header));\
+    ds_size buckets_offset = ds__MAP_FILE_ALIGN(controls_offset + capacity + ds_MAP_GROUP);\
+    ds__map_file_header header;\
+    ds_memset(&header, 0, sizeof(header));\
+    ds_memcpy(header.magic, ds__map_file_magic, sizeof(header.magic));\
+    header.version = ds__MAP_FILE_VERSION;\
+    header.endian = ds__MAP_FILE_ENDIAN;\
+    header.size_bytes = sizeof(ds_size);\
+    header.group = ds_MAP_GROUP;\
+    header.pow2 = ds_MAP_POW2;\
+    header.key_size = sizeof(K);\
+    header.value_size = sizeof(V);\
+    header.bucket_size = sizeof(ds__##name##_bucket);\
+    header.capacity = capacity;\
+    header.count = self->count;\
+    header.skips = self->skips;\
+    header.controls_offset = controls_offset;\
+    header.buckets_offset = buckets_offset;\
+    header.file_size = buckets_offset + sizeof(ds__##name##_bucket) * capacity;\
+    return header;\
+}\
+\
+ds_API static inline ds_bool ds__##name##_file_write(const name *self, FILE *file) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->old_controls == ds_NULL);\
+    ds_assert(file != ds_NULL);\
+    ds__map_file_header header = ds__##name##_file_header(self);\
+    ds_size capacity = self->buckets.capacity;\
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||\
+        !ds__map_file_pad(file, header.controls_offset - sizeof(header)) ||\
+        fwrite(self->controls, 1, capacity + ds_MAP_GROUP, file) != capacity + ds_MAP_GROUP ||\
+        !ds__map_file_pad(file, header.buckets_offset - header.controls_offset - capacity - ds_MAP_GROUP)) {\
+        return ds_false;\
+    }\
+    ds__##name##_bucket *chunk = (ds__##name##_bucket *) ds_malloc(sizeof(ds__##name##_bucket) * ds__MAP_FILE_CHUNK);\
+    ds_assert(chunk != ds_NULL);\
+    ds_bool written = ds_true;\
+    for (ds_size start = 0; written && start < capacity; start += ds__MAP_FILE_CHUNK) {\
+        ds_size size = capacity - start < ds__MAP_FILE_CHUNK ? capacity - start : ds__MAP_FILE_CHUNK;\
+        ds_memset(chunk, 0, sizeof(ds__##name##_bucket) * size);\
+        for (ds_size i = 0; i < size; ++i) {\
+            if (!(self->controls[start + i] & ds_BUCKET_EMPTY)) {\
+                chunk[i] = self->buckets.array[start + i];\
+            }\
+        }\
+        written = fwrite(chunk, sizeof(ds__##name##_bucket), size, file) == size;\
+    }\
+    ds_free(chunk);\
+    return written;\
+}\
+\
+ds_API static inline ds_bool name##_save(const name *self, const char *path) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->controls != ds_NULL);\
+    ds_assert(path != ds_NULL);\
+    FILE *file = fopen(path, "wb");\
+    if (file == ds_NULL) {\
+        return ds_false;\
+    }\
+    ds_bool saved;\
+    if (self->old_controls != ds_NULL) {\
+        name copy = name##_copy(self);\
+        name##_resize(&copy, copy.buckets.capacity);\
+        saved = ds__##name##_file_write(&copy, file);\
+        ds__##name##_vector_delete(&copy.buckets);\
+        ds_free(copy.controls);\
+    } else {\
+        saved = ds__##name##_file_write(self, file);\
+    }\
+    return (fclose(file) == 0) && saved;\
+}\
+\
+ds_API static inline ds_bool name##_open_mmap(name *self, const char *path) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(path != ds_NULL);\
+    int descriptor = open(path, O_RDONLY);\
+    if (descriptor < 0) {\
+        return ds_false;\
+    }\
+    struct stat status;\
+    if (fstat(descriptor, &status) != 0 || (ds_size) status.st_size < sizeof(ds__map_file_header)) {\
+        close(descriptor);\
+        return ds_false;\
+    }\
+    ds_size size = (ds_size) status.st_size;\
+    void *base = mmap(ds_NULL, size, PROT_READ, MAP_SHARED, descriptor, 0);\
+    close(descriptor);\
+    if (base == MAP_FAILED) {\
+        return ds_false;\
+    }\
+    const ds__map_file_header *header = (const ds__map_file_header *) base;\
+    ds_size capacity = (ds_size) header->capacity;\
+    if (ds_memcmp(header->magic, ds__map_file_magic, sizeof(header->magic)) != 0 ||\
+        header->version != ds__MAP_FILE_VERSION ||\
+        header->endian != ds__MAP_FILE_ENDIAN ||\
+        header->size_bytes != sizeof(ds_size) ||\
+        header->group != ds_MAP_GROUP ||\
+        header->pow2 != ds_MAP_POW2 ||\
+        header->key_size != sizeof(K) ||\
+        header->value_size != sizeof(V) ||\
+        header->bucket_size != sizeof(ds__##name##_bucket) ||\
+        capacity < ds_MAP_GROUP ||\
+        (ds_MAP_POW2 && (capacity & (capacity - 1)) != 0) ||\
+        header->count + header->skips > capacity ||\
+        header->controls_offset != ds__MAP_FILE_ALIGN(sizeof(ds__map_file_header)) ||\
+        header->buckets_offset != ds__MAP_FILE_ALIGN(header->controls_offset + capacity + ds_MAP_GROUP) ||\
+        header->file_size != header->buckets_offset + sizeof(ds__##name##_bucket) * capacity ||\
+        header->file_size != size) {\
+        munmap(base, size);\
+        return ds_false;\
+    }\
+    ds__map_file_advise(base, size);\
+    ds__##name##_vector buckets = {0};\
+    buckets.capacity = capacity;\
+    buckets.array = (ds__##name##_bucket *) ((ds_byte *) base + header->buckets_offset);\
+    *self = (name) {\
+        (ds_size) header->count,\
+        (ds_size) header->skips,\
+        (ds_byte *) base + header->controls_offset,\
+        buckets,\
+        ds_NULL,\
+        {0},\
+        0,\
+    };\
+    return ds_true;\
+}\
+\
+ds_API static inline void name##_close_mmap(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->controls != ds_NULL);\
+    ds_byte *base = self->controls - ds__MAP_FILE_ALIGN(sizeof(ds__map_file_header));\
+    const ds__map_file_header *header = (const ds__map_file_header *) base;\
+    ds_assert(ds_memcmp(header->magic, ds__map_file_magic, sizeof(header->magic)) == 0);\
+    munmap(base, (ds_size) header->file_size);\
+    *self = (name) {0};\
+}
+
+#endif // DS_MAP_FILE_H
@@ -0,0 +1,287 @@
+// .h
+// ds.h Minimal Perfect Hash Function Data Structure
+// by Kyle Furey
+
+/**
+ * ds_phf.h
+ *
+ * ds_DECLARE_PHF_NAMED(
+ *      name,               - The name of the data structure and function prefix.
+ *
+ *      K,                  - The key type to generate this data structure with.
+ *
+ *      key_hasher,         - Inline hashing code used to hash a key named <key>.
+ *                            You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                            ds_FAST_HASH and ds_FAST_STRING_HASH are faster for keys larger than a few bytes.
+ *
+ *      x_y_equals,         - Inline comparison code used to equate keys <x> and <y>.
+ *                            You can use ds_DEFAULT_EQUALS for trivial types.
+ * )
+ *
+ * This is a minimal perfect hash function built once for a fixed set of keys.
+ * It maps each of the <count> keys to its own index from 0 to <count> - 1, with no collisions and no unused indices.
+ * Values can then be stored in a plain array of <count> elements and found with a single index.
+ *
+ * Keys are split into buckets of about ds_PHF_BUCKET_SIZE keys by their hash.
+ * Each bucket stores one 32-bit pilot that moves its keys onto free indices (hash and displace, like CHD).
+ * Buckets with only one key store that key's index directly instead.
+ * Finding an index hashes the key once and reads one pilot.
+ *
+ * The function is one flat array of 32-bit numbers that may be saved and reopened with phf_open().
+ * It only works with the same key_hasher, ds_size width, and byte order it was built with.
+ * Keys that were not in the set still map to some index, so store keys beside values to check membership.
+ *
+ * Keys must be unique, and key_hasher must not return the same value for two of them, since every seed rehashes
+ * that value. Building stops after a fixed number of seeds instead of retrying forever.
+ *
+ * * Returns a new perfect hash function for the <count> unique keys in <keys>.
+ * * <count> must be greater than 0 and less than 2^31.
+ * * If the keys are not unique or share a key_hasher value, this asserts.
+ * * With asserts disabled, it returns a function whose phf_data() is NULL.
+ * * This data structure must be deleted with phf_delete().
+ *
+ *   phf              phf_new         ( const K* keys, size_t count )
+ *
+ * * Returns a perfect hash function that reads the flat array at <data>.
+ * * <data> must come from phf_data() and must outlive the function. It is not copied.
+ * * This data structure must be deleted with phf_delete().
+ *
+ *   phf              phf_open        ( const uint32_t* data )
+ *
+ * * Returns the number of keys in the function.
+ *
+ *   size_t           phf_count       ( const phf* self )
+ *
+ * * Returns the index of <key> from 0 to phf_count() - 1.
+ *
+ *   size_t           phf_index       ( const phf* self, K key )
+ *
+ * * Returns the flat array that stores the function.
+ *
+ *   const uint32_t*  phf_data        ( const phf* self )
+ *
+ * * Returns the size of the flat array in bytes.
+ *
+ *   size_t           phf_size        ( const phf* self )
+ *
+ * * Safely deletes a perfect hash function.
+ *
+ *   void             phf_delete      ( phf* self )
+ */
+
+#ifndef DS_PHF_H
+#define DS_PHF_H
+
+#include "ds_def.h"
+
+/** Marks the start of a perfect hash function's flat array. */
+#define ds__PHF_MAGIC 0x31464850u
+
+/** The number of numbers before the pilots in a perfect hash function's flat array. */
+#define ds__PHF_HEADER 4
+
+/** The number of pilots tried for one bucket before a new seed is chosen. */
+#define ds__PHF_PILOTS (1u << 16)
+
+/** The number of seeds tried before building a perfect hash function fails. */
+#define ds__PHF_SEEDS 64
+
+/** Marks a pilot that stores the index of a bucket's only key. */
+#define ds__PHF_DIRECT 0x80000000u
+
+/** Declares a named minimal perfect hash function of the given key type. */
+#define ds_DECLARE_PHF_NAMED(name, K, key_hasher, x_y_equals)\
+\
+typedef struct {\
+    const uint32_t *data;\
+    uint32_t *owned;\
+} name;\
+\
+ds_API static inline ds_size ds__##name##_hash(K key, uint32_t seed) {\
+    ds_size hash = ds_hash_mix((key_hasher));\
+    return ds_fast_hashify_seeded(sizeof(hash), &hash, seed);\
+}\
+\
+ds_API static inline ds_size ds__##name##_position(ds_size hash, uint32_t pilot, ds_size count) {\
+    if (pilot & ds__PHF_DIRECT) {\
+        return pilot & ~ds__PHF_DIRECT;\
+    }\
+    return (ds_hash_mix(hash) ^ ds_hash_mix((ds_size) pilot + 1)) % count;\
+}\
+\
+ds_API static inline ds_bool ds__##name##_build(const K *keys, ds_size count, uint32_t *data, uint32_t seed,\
+                                                ds_size *hashes, ds_size *starts, ds_size *order, ds_byte *taken,\
+                                                ds_bool *collided) {\
+    ds_size buckets = data[2];\
+    ds_size *members = order + count;\
+    ds_size *sizes = members + count;\
+    ds_memset(starts, 0, sizeof(ds_size) * (buckets + 1));\
+    for (ds_size i = 0; i < count; ++i) {\
+        hashes[i] = ds__##name##_hash(keys[i], seed);\
+        ++starts[hashes[i] % buckets + 1];\
+    }\
+    for (ds_size i = 0; i < buckets; ++i) {\
+        starts[i + 1] += starts[i];\
+    }\
+    for (ds_size i = 0; i < count; ++i) {\
+        members[starts[hashes[i] % buckets]++] = i;\
+    }\
+    for (ds_size i = buckets; i > 0; --i) {\
+        starts[i] = starts[i - 1];\
+    }\
+    starts[0] = 0;\
+    ds_size largest = 0;\
+    for (ds_size i = 0; i < buckets; ++i) {\
+        if (starts[i + 1] - starts[i] > largest) {\
+            largest = starts[i + 1] - starts[i];\
+        }\
+    }\
+    ds_memset(sizes, 0, sizeof(ds_size) * (largest + 2));\
+    for (ds_size i = 0; i < buckets; ++i) {\
+        ++sizes[largest - (starts[i + 1] - starts[i]) + 1];\
+    }\
+    for (ds_size i = 0; i <= largest; ++i) {\
+        sizes[i + 1] += sizes[i];\
+    }\
+    for (ds_size i = 0; i < buckets; ++i) {\
+        order[sizes[largest - (starts[i + 1] - starts[i])]++] = i;\
+    }\
+    ds_memset(taken, 0, count);\
+    ds_size slot = 0;\
+    for (ds_size i = 0; i < buckets; ++i) {\
+        ds_size bucket = order[i];\
+        ds_size start = starts[bucket];\
+        ds_size end = starts[bucket + 1];\
+        if (end - start <= 1) {\
+            if (start == end) {\
+                data[ds__PHF_HEADER + bucket] = 0;\
+                continue;\
+            }\
+            while (taken[slot]) {\
+                ++slot;\
+            }\
+            taken[slot] = 1;\
+            data[ds__PHF_HEADER + bucket] = ds__PHF_DIRECT | (uint32_t) slot;\
+            continue;\
+        }\
+        uint32_t pilot = 0;\
+        for (; pilot < ds__PHF_PILOTS; ++pilot) {\
+            ds_size placed = start;\
+            for (; placed < end; ++placed) {\
+                ds_size position = ds__##name##_position(hashes[members[placed]], pilot, count);\
+                if (taken[position]) {\
+                    break;\
+                }\
+                taken[position] = 1;\
+            }\
+            if (placed == end) {\
+                break;\
+            }\
+            for (ds_size j = start; j < placed; ++j) {\
+                taken[ds__##name##_position(hashes[members[j]], pilot, count)] = 0;\
+            }\
+        }\
+        if (pilot == ds__PHF_PILOTS) {\
+            for (ds_size j = start; j + 1 < end; ++j) {\
+                for (ds_size k = j + 1; k < end; ++k) {\
+                    if (hashes[members[j]] == hashes[members[k]]) {\
+                        K x = keys[members[j]];\
+                        K y = keys[members[k]];\
+                        ds_assert(!(x_y_equals) && "Perfect hash keys must be unique!");\
+                        (void) x;\
+                        (void) y;\
+                        *collided = ds_true;\
+                    }\
+                }\
+            }\
+            return ds_false;\
+        }\
+        data[ds__PHF_HEADER + bucket] = pilot;\
+    }\
+    return ds_true;\
+}\
+\
+ds_API static inline name name##_new(const K *keys, ds_size count) {\
+    ds_assert(keys != ds_NULL);\
+    ds_assert(count > 0 && count < ds__PHF_DIRECT);\
+    ds_size buckets = count / ds_PHF_BUCKET_SIZE + 1;\
+    uint32_t *data = (uint32_t *) ds_malloc(sizeof(uint32_t) * (ds__PHF_HEADER + buckets));\
+    ds_size *hashes = (ds_size *) ds_malloc(sizeof(ds_size) * (count * 4 + buckets * 2 + 2));\
+    ds_byte *taken = (ds_byte *) ds_malloc(count);\
+    ds_assert(data != ds_NULL);\
+    ds_assert(hashes != ds_NULL);\
+    ds_assert(taken != ds_NULL);\
+    data[0] = ds__PHF_MAGIC;\
+    data[1] = (uint32_t) count;\
+    data[2] = (uint32_t) buckets;\
+    ds_bool collided = ds_false;\
+    ds_bool built = ds_false;\
+    uint32_t seed = 0;\
+    for (; !built && !collided && seed < ds__PHF_SEEDS; ++seed) {\
+        built = ds__##name##_build(keys, count, data, seed, hashes, hashes + count, hashes + count + buckets + 1, taken,\
+                                   &collided);\
+    }\
+    ds_free(hashes);\
+    ds_free(taken);\
+    if (!built) {\
+        ds_assert(!collided && "Perfect hash keys must not share a key_hasher value!");\
+        ds_assert(built && "Perfect hash function could not be built!");\
+        ds_free(data);\
+        return (name) {\
+            ds_NULL,\
+            ds_NULL,\
+        };\
+    }\
+    data[3] = seed - 1;\
+    return (name) {\
+        data,\
+        data,\
+    };\
+}\
+\
+ds_API static inline name name##_open(const uint32_t *data) {\
+    ds_assert(data != ds_NULL);\
+    ds_assert(data[0] == ds__PHF_MAGIC);\
+    ds_assert(data[1] > 0 && data[2] > 0);\
+    return (name) {\
+        data,\
+        ds_NULL,\
+    };\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->data != ds_NULL);\
+    return self->data[1];\
+}\
+\
+ds_API static inline ds_size name##_index(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->data != ds_NULL);\
+    ds_size hash = ds__##name##_hash(key, self->data[3]);\
+    uint32_t pilot = self->data[ds__PHF_HEADER + hash % self->data[2]];\
+    return ds__##name##_position(hash, pilot, self->data[1]);\
+}\
+\
+ds_API static inline const uint32_t *name##_data(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->data;\
+}\
+\
+ds_API static inline ds_size name##_size(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->data != ds_NULL);\
+    return sizeof(uint32_t) * (ds__PHF_HEADER + self->data[2]);\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_free(self->owned);\
+    *self = (name) {0};\
+}
+
+/** Declares a minimal perfect hash function of the given key type. */
+#define ds_DECLARE_PHF(K, key_hasher, x_y_equals)\
+        ds_DECLARE_PHF_NAMED(K##_phf, K, key_hasher, x_y_equals)
+
+#endif // DS_PHF_H
@@ -0,0 +1,391 @@
+// .h
+// ds.h Persistent Sorted Set Data Structure
+// by Kyle Furey
+
+/**
+ * ds_pset.h
+ *
+ * ds_DECLARE_PSET_NAMED(
+ *      name,               - The name of the data structure and function prefix.
+ *
+ *      T,                  - The type to generate this data structure with.
+ *
+ *      x_y_comparer,       - Inline comparison code used to compare values <x> and <y>.
+ *                            You can use ds_DEFAULT_COMPARE for trivial types.
+ *
+ *      x_y_equals,         - Inline comparison code used to equate values <x> and <y>.
+ *                            You can use ds_DEFAULT_EQUALS for trivial types.
+ * )
+ *
+ * This is a persistent sorted set. It is a balanced AVL tree of reference counted nodes.
+ * Copying a set is O(1) and returns a snapshot that shares every node with the original.
+ * Updates copy only the O(log n) nodes on the path to the change, so snapshots never change.
+ * Nodes that are not shared with any snapshot are updated in place without copying.
+ *
+ * This is excellent for handing readers consistent versions of data that is updated often.
+ * A version's nodes are freed automatically once every set sharing them is deleted.
+ *
+ * Elements are shared between versions by value and are never deleted by the set.
+ * Use trivial types or manage the lifetime of owned memory outside the set.
+ *
+ * * Returns a new set.
+ * * This data structure must be deleted with pset_delete().
+ *
+ *   pset         pset_new            ( void )
+ *
+ * * Returns an O(1) snapshot of <set>.
+ * * Neither set observes later updates to the other.
+ * * The snapshot must be deleted with pset_delete().
+ *
+ *   pset         pset_copy           ( const pset* set )
+ *
+ * * Returns the number of elements in the set.
+ *
+ *   size_t       pset_count          ( const pset* self )
+ *
+ * * Returns whether the set is empty.
+ *
+ *   bool         pset_empty          ( const pset* self )
+ *
+ * * Returns a pointer to the least value in the set.
+ * * The set must not be empty.
+ *
+ *   const T*     pset_least          ( const pset* self )
+ *
+ * * Returns a pointer to the greatest value in the set.
+ * * The set must not be empty.
+ *
+ *   const T*     pset_greatest       ( const pset* self )
+ *
+ * * Returns a pointer to a value that matches <data> in the set.
+ * * Returns NULL if no value matches.
+ *
+ *   const T*     pset_find           ( const pset* self, T data )
+ *
+ * * Returns whether the set contains <data>.
+ *
+ *   bool         pset_contains       ( const pset* self, T data )
+ *
+ * * Inserts a new element into the set.
+ * * Returns whether a value was overwritten.
+ *
+ *   bool         pset_insert         ( pset* self, T data )
+ *
+ * * Removes an element from the set.
+ * * Returns whether an element was removed.
+ *
+ *   bool         pset_erase          ( pset* self, T data )
+ *
+ * * Removes all elements from the set.
+ *
+ *   void         pset_clear          ( pset* self )
+ *
+ * * Iterates the set in-order calling <action> on each element.
+ *
+ *   void         pset_foreach        ( const pset* self, void (*action)(T) )
+ *
+ * * Safely deletes a set.
+ * * Nodes are only freed once no other snapshot shares them.
+ *
+ *   void         pset_delete         ( pset* self )
+ */
+
+#ifndef DS_PSET_H
+#define DS_PSET_H
+
+#include "ds_def.h"
+
+/** Declares a named persistent sorted set of the given type. */
+#define ds_DECLARE_PSET_NAMED(name, T, x_y_comparer, x_y_equals)\
+\
+typedef struct ds__##name##_node {\
+    T data;\
+    struct ds__##name##_node *left;\
+    struct ds__##name##_node *right;\
+    ds_uint refs;\
+    ds_uint height;\
+} ds__##name##_node;\
+\
+typedef struct {\
+    ds_size count;\
+    ds__##name##_node *root;\
+} name;\
+\
+ds_API static inline ds_uint ds__##name##_height(const ds__##name##_node *node) {\
+    return node != ds_NULL ? node->height : 0;\
+}\
+\
+ds_API static inline void ds__##name##_update(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL);\
+    ds_uint left = ds__##name##_height(node->left);\
+    ds_uint right = ds__##name##_height(node->right);\
+    node->height = (left > right ? left : right) + 1;\
+}\
+\
+ds_API static inline void ds__##name##_retain(ds__##name##_node *node) {\
+    if (node != ds_NULL) {\
+        ds_assert(node->refs > 0);\
+        ++node->refs;\
+    }\
+}\
+\
+ds_API static inline void ds__##name##_release(ds__##name##_node *node) {\
+    while (node != ds_NULL) {\
+        ds_assert(node->refs > 0);\
+        if (--node->refs > 0) {\
+            return;\
+        }\
+        ds__##name##_node *right = node->right;\
+        ds__##name##_release(node->left);\
+        ds_free(node);\
+        node = right;\
+    }\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_own(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL);\
+    ds_assert(node->refs > 0);\
+    if (node->refs == 1) {\
+        return node;\
+    }\
+    ds__##name##_node *copy = (ds__##name##_node *) ds_malloc(sizeof(ds__##name##_node));\
+    ds_assert(copy != ds_NULL);\
+    *copy = *node;\
+    copy->refs = 1;\
+    ds__##name##_retain(copy->left);\
+    ds__##name##_retain(copy->right);\
+    --node->refs;\
+    return copy;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_rotate_left(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL && node->refs == 1);\
+    ds__##name##_node *right = ds__##name##_own(node->right);\
+    node->right = right->left;\
+    right->left = node;\
+    ds__##name##_update(node);\
+    ds__##name##_update(right);\
+    return right;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_rotate_right(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL && node->refs == 1);\
+    ds__##name##_node *left = ds__##name##_own(node->left);\
+    node->left = left->right;\
+    left->right = node;\
+    ds__##name##_update(node);\
+    ds__##name##_update(left);\
+    return left;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_balance(ds__##name##_node *node) {\
+    ds_assert(node != ds_NULL && node->refs == 1);\
+    ds__##name##_update(node);\
+    ds_uint left = ds__##name##_height(node->left);\
+    ds_uint right = ds__##name##_height(node->right);\
+    if (left > right + 1) {\
+        if (ds__##name##_height(node->left->left) < ds__##name##_height(node->left->right)) {\
+            node->left = ds__##name##_rotate_left(ds__##name##_own(node->left));\
+        }\
+        return ds__##name##_rotate_right(node);\
+    }\
+    if (right > left + 1) {\
+        if (ds__##name##_height(node->right->right) < ds__##name##_height(node->right->left)) {\
+            node->right = ds__##name##_rotate_right(ds__##name##_own(node->right));\
+        }\
+        return ds__##name##_rotate_left(node);\
+    }\
+    return node;\
+}\
+\
+ds_API static inline name name##_new(void) {\
+    return (name) {\
+        0,\
+        ds_NULL,\
+    };\
+}\
+\
+ds_API static inline name name##_copy(const name *set) {\
+    ds_assert(set != ds_NULL);\
+    ds_assert((set->root == ds_NULL) == (set->count == 0));\
+    ds__##name##_retain(set->root);\
+    return *set;\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->count;\
+}\
+\
+ds_API static inline ds_bool name##_empty(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->count == 0;\
+}\
+\
+ds_API static inline const T *name##_least(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->count > 0);\
+    ds_assert(self->root != ds_NULL);\
+    const ds__##name##_node *current = self->root;\
+    while (current->left != ds_NULL) {\
+        current = current->left;\
+    }\
+    return &current->data;\
+}\
+\
+ds_API static inline const T *name##_greatest(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->count > 0);\
+    ds_assert(self->root != ds_NULL);\
+    const ds__##name##_node *current = self->root;\
+    while (current->right != ds_NULL) {\
+        current = current->right;\
+    }\
+    return &current->data;\
+}\
+\
+ds_API static inline const T *name##_find(const name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    const ds__##name##_node *current = self->root;\
+    ds_assert((current == ds_NULL) == (self->count == 0));\
+    while (current != ds_NULL) {\
+        T x = data;\
+        T y = current->data;\
+        if ((x_y_equals)) {\
+            return &current->data;\
+        }\
+        if ((x_y_comparer)) {\
+            current = current->right;\
+        } else {\
+            current = current->left;\
+        }\
+    }\
+    return ds_NULL;\
+}\
+\
+ds_API static inline ds_bool name##_contains(const name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    return name##_find(self, data) != ds_NULL;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_insert(ds__##name##_node *node, T data, ds_bool *replaced) {\
+    ds_assert(replaced != ds_NULL);\
+    if (node == ds_NULL) {\
+        node = (ds__##name##_node *) ds_malloc(sizeof(ds__##name##_node));\
+        ds_assert(node != ds_NULL);\
+        node->data = data;\
+        node->left = ds_NULL;\
+        node->right = ds_NULL;\
+        node->refs = 1;\
+        node->height = 1;\
+        return node;\
+    }\
+    node = ds__##name##_own(node);\
+    T x = data;\
+    T y = node->data;\
+    if ((x_y_equals)) {\
+        node->data = data;\
+        *replaced = ds_true;\
+        return node;\
+    }\
+    if ((x_y_comparer)) {\
+        node->right = ds__##name##_insert(node->right, data, replaced);\
+    } else {\
+        node->left = ds__##name##_insert(node->left, data, replaced);\
+    }\
+    return ds__##name##_balance(node);\
+}\
+\
+ds_API static inline ds_bool name##_insert(name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    ds_bool replaced = ds_false;\
+    self->root = ds__##name##_insert(self->root, data, &replaced);\
+    if (!replaced) {\
+        ++self->count;\
+    }\
+    return replaced;\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_erase_least(ds__##name##_node *node, T *least) {\
+    ds_assert(node != ds_NULL && least != ds_NULL);\
+    node = ds__##name##_own(node);\
+    if (node->left == ds_NULL) {\
+        ds__##name##_node *right = node->right;\
+        *least = node->data;\
+        ds_free(node);\
+        return right;\
+    }\
+    node->left = ds__##name##_erase_least(node->left, least);\
+    return ds__##name##_balance(node);\
+}\
+\
+ds_API static inline ds__##name##_node *ds__##name##_erase(ds__##name##_node *node, T data) {\
+    ds_assert(node != ds_NULL);\
+    node = ds__##name##_own(node);\
+    T x = data;\
+    T y = node->data;\
+    if ((x_y_equals)) {\
+        if (node->left == ds_NULL || node->right == ds_NULL) {\
+            ds__##name##_node *child = node->left != ds_NULL ? node->left : node->right;\
+            ds_free(node);\
+            return child;\
+        }\
+        node->right = ds__##name##_erase_least(node->right, &node->data);\
+    } else if ((x_y_comparer)) {\
+        node->right = ds__##name##_erase(node->right, data);\
+    } else {\
+        node->left = ds__##name##_erase(node->left, data);\
+    }\
+    return ds__##name##_balance(node);\
+}\
+\
+ds_API static inline ds_bool name##_erase(name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    if (!name##_contains(self, data)) {\
+        return ds_false;\
+    }\
+    ds_assert(self->count > 0);\
+    self->root = ds__##name##_erase(self->root, data);\
+    --self->count;\
+    return ds_true;\
+}\
+\
+ds_API static inline void name##_clear(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert((self->root == ds_NULL) == (self->count == 0));\
+    ds__##name##_release(self->root);\
+    self->count = 0;\
+    self->root = ds_NULL;\
+}\
+\
+ds_API static inline void ds__##name##_foreach(const ds__##name##_node *node, void(*action)(T)) {\
+    ds_assert(node != ds_NULL && action != ds_NULL);\
+    if (node->left != ds_NULL) {\
+        ds__##name##_foreach(node->left, action);\
+    }\
+    action(node->data);\
+    if (node->right != ds_NULL) {\
+        ds__##name##_foreach(node->right, action);\
+    }\
+}\
+\
+ds_API static inline void name##_foreach(const name *self, void(*action)(T)) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(action != ds_NULL);\
+    ds_assert((self->root == ds_NULL) == (self->count == 0));\
+    if (self->root != ds_NULL) {\
+        ds__##name##_foreach(self->root, action);\
+    }\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    name##_clear(self);\
+    *self = (name) {0};\
+}
+
+/** Declares a persistent sorted set of the given type. */
+#define ds_DECLARE_PSET(T, x_y_comparer, x_y_equals)\
+        ds_DECLARE_PSET_NAMED(T##_pset, T, x_y_comparer, x_y_equals)
+
+#endif // DS_PSET_H
@@ -19,6 +19,21 @@
  *                            ds_void_deleter may be used for trivial types.
  * )
  *
+ * ds_DECLARE_QUEUE3_NAMED(
+ *      name,               - The name of the data structure and function prefix.
+ *
+ *      T,                  - The type to generate this data structure with.
+ *
+ *      P,                  - The type used to sort T.
+ *
+ *      x_y_compare,        - Inline three-way comparison code used to compare priorities <x> and <y>.
+ *                            Must be negative if x < y, zero if x == y, and positive if x > y.
+ *                            You can use ds_DEFAULT_COMPARE3 or ds_STRING_COMPARE3.
+ *
+ *      deleter,            - The name of the function used to deallocate T.
+ *                            ds_void_deleter may be used for trivial types.
+ * )
+ *
  * This is a double-ended priority queue. It's a linked list with automatic ordering.
  * Elements are sorted via a priority value. The first and last element are O(1) accessible.
  * If you don't need priority ordering, use a regular linked list or vector.
@@ -245,8 +260,16 @@ ds_API static inline void name##_delete(name *self) {\
     *self = (name) {0};\
 }
 
+/** Declares a named priority queue of the given types with a three-way comparison. */
+#define ds_DECLARE_QUEUE3_NAMED(name, T, P, x_y_compare, deleter)\
+        ds_DECLARE_QUEUE_NAMED(name, T, P, (x_y_compare) > 0, deleter)
+
 /** Declares a priority queue of the given types. */
 #define ds_DECLARE_QUEUE(T, P, x_y_comparer, deleter)\
         ds_DECLARE_QUEUE_NAMED(T##_queue, T, P, x_y_comparer, deleter)
 
+/** Declares a priority queue of the given types with a three-way comparison. */
+#define ds_DECLARE_QUEUE3(T, P, x_y_compare, deleter)\
+        ds_DECLARE_QUEUE3_NAMED(T##_queue, T, P, x_y_compare, deleter)
+
 #endif // DS_QUEUE_H
@@ -0,0 +1,294 @@
+// .h
+// ds.h Read-Copy-Update Hash Map Data Structure
+// by Kyle Furey
+
+/**
+ * ds_rcu_map.h
+ *
+ * ds_DECLARE_RCU_MAP_NAMED(
+ *      name,           - The name of the data structure and function prefix.
+ *
+ *      K,              - The key type used to index V.
+ *
+ *      V,              - The value type to generate this data structure with.
+ *                        V must be trivially copyable since versions of the map share their values.
+ *
+ *      key_hasher,     - Inline hashing code used to hash a key named <key>.
+ *                        You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                        ds_FAST_HASH and ds_FAST_STRING_HASH are faster for keys larger than a few bytes.
+ *
+ *      x_y_equals,     - Inline comparison code used to equate keys <x> and <y>.
+ *                        You can use ds_DEFAULT_EQUALS for trivial types.
+ * )
+ *
+ * This is a hash map for data that is read very often and changed rarely.
+ * Its contents are an immutable ds_map.h map called a snapshot, declared as name_snapshot.
+ *
+ * Readers load the current snapshot without locks or read-modify-write atomics.
+ * Each reading thread registers a reader slot and publishes the epoch it started reading in.
+ *
+ * Writers copy the current snapshot, change the copy with the usual map functions, and publish it.
+ * Many changes can be batched into one copy. Writers are serialized with a lock.
+ * Replaced snapshots are freed once every reader that could still see them has finished.
+ *
+ * Keys that point to memory must outlive every snapshot that contains them.
+ *
+ * This header requires POSIX threads and GCC or Clang atomics, so ds.h does not include it.
+ *
+ * * Returns a new RCU map with an empty snapshot of <capacity> buckets and room for <readers> reader slots.
+ * * <capacity> and <readers> must be greater than 0.
+ * * This data structure must be deleted with rcu_map_delete().
+ *
+ *   rcu_map                 rcu_map_new                ( size_t capacity, size_t readers )
+ *
+ * * Claims a reader slot for the calling thread.
+ * * Returns the slot, or ds_NOT_FOUND if every slot is in use.
+ *
+ *   size_t                  rcu_map_reader_register    ( rcu_map* self )
+ *
+ * * Frees a reader slot. The slot must not be reading.
+ *
+ *   void                    rcu_map_reader_unregister  ( rcu_map* self, size_t reader )
+ *
+ * * Starts reading with <reader> and returns the current snapshot.
+ * * The snapshot may be read with rcu_map_snapshot_find_const() and other const map functions until rcu_map_read_end().
+ * * Read sections may not be nested on the same slot.
+ *
+ *   const rcu_map_snapshot* rcu_map_read_begin         ( rcu_map* self, size_t reader )
+ *
+ * * Stops reading with <reader>. The snapshot returned by rcu_map_read_begin() may be freed after this.
+ *
+ *   void                    rcu_map_read_end           ( rcu_map* self, size_t reader )
+ *
+ * * Copies the value that matches <key> into <value> in its own read section.
+ * * Returns whether <key> was found. <value> is not changed if it was not.
+ *
+ *   bool                    rcu_map_find               ( rcu_map* self, size_t reader, K key, V* value )
+ *
+ * * Locks the map for writing and returns a private copy of the current snapshot.
+ * * The copy may be changed with any map function before it is passed to rcu_map_write_end() or rcu_map_write_cancel().
+ *
+ *   rcu_map_snapshot*       rcu_map_write_begin        ( rcu_map* self )
+ *
+ * * Publishes <snapshot> as the current snapshot and unlocks the map.
+ * * The replaced snapshot is freed once no reader can still see it.
+ *
+ *   void                    rcu_map_write_end          ( rcu_map* self, rcu_map_snapshot* snapshot )
+ *
+ * * Discards <snapshot> and unlocks the map.
+ *
+ *   void                    rcu_map_write_cancel       ( rcu_map* self, rcu_map_snapshot* snapshot )
+ *
+ * * Frees every replaced snapshot that no reader can still see.
+ * * Returns the number of replaced snapshots that are still waiting on readers.
+ *
+ *   size_t                  rcu_map_reclaim            ( rcu_map* self )
+ *
+ * * Safely deletes an RCU map and every snapshot it still holds.
+ * * No other thread may use the map while it is deleted.
+ *
+ *   void                    rcu_map_delete             ( rcu_map* self )
+ */
+
+#ifndef DS_RCU_MAP_H
+#define DS_RCU_MAP_H
+
+#include <pthread.h>
+#include "ds_map.h"
+
+/** Declares a named read-copy-update hash map of the given types. */
+#define ds_DECLARE_RCU_MAP_NAMED(name, K, V, key_hasher, x_y_equals)\
+\
+ds_DECLARE_MAP_NAMED(name##_snapshot, K, V, key_hasher, x_y_equals, ds_void_deleter)\
+\
+typedef struct {\
+    ds_size epoch;\
+    ds_bool used;\
+    ds_byte padding[ds_CACHE_LINE];\
+} ds__##name##_reader;\
+\
+typedef struct {\
+    name##_snapshot *snapshot;\
+    ds_size epoch;\
+} ds__##name##_retired;\
+\
+typedef struct {\
+    name##_snapshot *current;\
+    ds_size epoch;\
+    pthread_mutex_t lock;\
+    ds__##name##_reader *readers;\
+    ds_size reader_count;\
+    ds__##name##_retired *retired;\
+    ds_size retired_count;\
+} name;\
+\
+ds_API static inline void ds__##name##_free(name##_snapshot *snapshot) {\
+    ds_assert(snapshot != ds_NULL);\
+    name##_snapshot_delete(snapshot);\
+    ds_free(snapshot);\
+}\
+\
+ds_API static inline name name##_new(ds_size capacity, ds_size readers) {\
+    ds_assert(capacity > 0);\
+    ds_assert(readers > 0);\
+    name self = (name) {\
+        (name##_snapshot *) ds_malloc(sizeof(name##_snapshot)),\
+        1,\
+        PTHREAD_MUTEX_INITIALIZER,\
+        (ds__##name##_reader *) ds_calloc(readers, sizeof(ds__##name##_reader)),\
+        readers,\
+        ds_NULL,\
+        0,\
+    };\
+    ds_assert(self.current != ds_NULL);\
+    ds_assert(self.readers != ds_NULL);\
+    *self.current = name##_snapshot_new(capacity);\
+    return self;\
+}\
+\
+ds_API static inline ds_size name##_reader_register(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->readers != ds_NULL);\
+    ds_size reader = ds_NOT_FOUND;\
+    pthread_mutex_lock(&self->lock);\
+    for (ds_size i = 0; i < self->reader_count; ++i) {\
+        if (!self->readers[i].used) {\
+            self->readers[i].used = ds_true;\
+            reader = i;\
+            break;\
+        }\
+    }\
+    pthread_mutex_unlock(&self->lock);\
+    return reader;\
+}\
+\
+ds_API static inline void name##_reader_unregister(name *self, ds_size reader) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->readers != ds_NULL);\
+    ds_assert(reader < self->reader_count);\
+    ds_assert(self->readers[reader].used);\
+    ds_assert(self->readers[reader].epoch == 0);\
+    pthread_mutex_lock(&self->lock);\
+    self->readers[reader].used = ds_false;\
+    pthread_mutex_unlock(&self->lock);\
+}\
+\
+ds_API static inline const name##_snapshot *name##_read_begin(name *self, ds_size reader) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->readers != ds_NULL);\
+    ds_assert(reader < self->reader_count);\
+    ds_assert(self->readers[reader].used);\
+    ds_assert(self->readers[reader].epoch == 0);\
+    __atomic_store_n(&self->readers[reader].epoch, __atomic_load_n(&self->epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);\
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);\
+    return __atomic_load_n(&self->current, __ATOMIC_ACQUIRE);\
+}\
+\
+ds_API static inline void name##_read_end(name *self, ds_size reader) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->readers != ds_NULL);\
+    ds_assert(reader < self->reader_count);\
+    ds_assert(self->readers[reader].epoch != 0);\
+    __atomic_store_n(&self->readers[reader].epoch, 0, __ATOMIC_RELEASE);\
+}\
+\
+ds_API static inline ds_bool name##_find(name *self, ds_size reader, K key, V *value) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(value != ds_NULL);\
+    const V *found = name##_snapshot_find_const(name##_read_begin(self, reader), key);\
+    if (found != ds_NULL) {\
+        *value = *found;\
+    }\
+    name##_read_end(self, reader);\
+    return found != ds_NULL;\
+}\
+\
+ds_API static inline ds_size ds__##name##_reclaim(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->readers != ds_NULL);\
+    if (self->retired_count == 0) {\
+        return 0;\
+    }\
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);\
+    ds_size oldest = ds_SIZE_MAX;\
+    for (ds_size i = 0; i < self->reader_count; ++i) {\
+        ds_size epoch = __atomic_load_n(&self->readers[i].epoch, __ATOMIC_ACQUIRE);\
+        if (epoch != 0 && epoch < oldest) {\
+            oldest = epoch;\
+        }\
+    }\
+    ds_size count = 0;\
+    for (ds_size i = 0; i < self->retired_count; ++i) {\
+        if (self->retired[i].epoch < oldest) {\
+            ds__##name##_free(self->retired[i].snapshot);\
+        } else {\
+            self->retired[count++] = self->retired[i];\
+        }\
+    }\
+    self->retired_count = count;\
+    return count;\
+}\
+\
+ds_API static inline ds_size name##_reclaim(name *self) {\
+    ds_assert(self != ds_NULL);\
+    pthread_mutex_lock(&self->lock);\
+    ds_size count = ds__##name##_reclaim(self);\
+    pthread_mutex_unlock(&self->lock);\
+    return count;\
+}\
+\
+ds_API static inline name##_snapshot *name##_write_begin(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->current != ds_NULL);\
+    pthread_mutex_lock(&self->lock);\
+    name##_snapshot *snapshot = (name##_snapshot *) ds_malloc(sizeof(name##_snapshot));\
+    ds_assert(snapshot != ds_NULL);\
+    *snapshot = name##_snapshot_copy(self->current);\
+    return snapshot;\
+}\
+\
+ds_API static inline void name##_write_end(name *self, name##_snapshot *snapshot) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(snapshot != ds_NULL);\
+    ds_assert(snapshot != self->current);\
+    ds__##name##_retired *retired = (ds__##name##_retired *)\
+            ds_realloc(self->retired, sizeof(ds__##name##_retired) * (self->retired_count + 1));\
+    ds_assert(retired != ds_NULL);\
+    self->retired = retired;\
+    self->retired[self->retired_count++] = (ds__##name##_retired) {\
+        self->current,\
+        self->epoch,\
+    };\
+    __atomic_store_n(&self->current, snapshot, __ATOMIC_SEQ_CST);\
+    __atomic_store_n(&self->epoch, self->epoch + 1, __ATOMIC_SEQ_CST);\
+    ds__##name##_reclaim(self);\
+    pthread_mutex_unlock(&self->lock);\
+}\
+\
+ds_API static inline void name##_write_cancel(name *self, name##_snapshot *snapshot) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(snapshot != ds_NULL);\
+    ds_assert(snapshot != self->current);\
+    ds__##name##_free(snapshot);\
+    pthread_mutex_unlock(&self->lock);\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->current != ds_NULL);\
+    ds_assert(self->readers != ds_NULL);\
+    for (ds_size i = 0; i < self->retired_count; ++i) {\
+        ds__##name##_free(self->retired[i].snapshot);\
+    }\
+    ds_free(self->retired);\
+    ds__##name##_free(self->current);\
+    ds_free(self->readers);\
+    pthread_mutex_destroy(&self->lock);\
+    *self = (name) {0};\
+}
+
+/** Declares a read-copy-update hash map of the given types. */
+#define ds_DECLARE_RCU_MAP(K, V, key_hasher, x_y_equals)\
+        ds_DECLARE_RCU_MAP_NAMED(K##_##V##_rcu_map, K, V, key_hasher, x_y_equals)
+
+#endif // DS_RCU_MAP_H
@@ -20,6 +20,19 @@
  *                            ds_void_deleter may be used for trivial types.
  * )
  *
+ * ds_DECLARE_SET3_NAMED(
+ *      name,               - The name of the data structure and function prefix.
+ *
+ *      T,                  - The type to generate this data structure with.
+ *
+ *      x_y_compare,        - Inline three-way comparison code used to compare values <x> and <y>.
+ *                            Must be negative if x < y, zero if x == y, and positive if x > y.
+ *                            You can use ds_DEFAULT_COMPARE3 or ds_STRING_COMPARE3.
+ *
+ *      deleter,            - The name of the function used to deallocate T.
+ *                            ds_void_deleter may be used for trivial types.
+ * )
+ *
  * This is a sorted binary tree that stores a collection of unique elements.
  * Elements are inserted relative to their neighbors to ensure order is kept.
  * Sets are great for storing and checking whether an element exists.
@@ -28,11 +41,21 @@
  * Sets are great for storing unique values. New elements replace "identical" elements on insert.
  * Mathematical operations like subset and union allow easy set comparison and combination.
  *
+ * Three-way sets evaluate a single comparison per node instead of an equality and an ordering.
+ * Prefer them when comparing elements is expensive, like with strings.
+ *
  * * Returns a new set.
  * * This data structure must be deleted with set_delete().
  *
  *   set          set_new             ( void )
  *
+ * * Returns a new perfectly balanced set built from <count> elements in <data>.
+ * * <data> is sorted first unless <sorted> is true. Duplicates keep their last occurrence.
+ * * All nodes are allocated in a single block. This is O(n) for sorted data.
+ * * This data structure must be deleted with set_delete().
+ *
+ *   set          set_from_array      ( const T* data, size_t count, bool sorted )
+ *
  * * Returns a new set copied from <set>.
  * * The new slab owns its own memory and must be deleted with set_delete().
  *
@@ -113,8 +136,8 @@
 
 #include "ds_def.h"
 
-/** Declares a named sorted binary tree set of the given type. */
-#define ds_DECLARE_SET_NAMED(name, T, x_y_comparer, x_y_equals, deleter)\
+/** Declares a named sorted binary tree set of the given type with every form of comparison. */
+#define ds__DECLARE_SET_CORE(name, T, x_y_comparer, x_y_equals, x_y_compare, deleter)\
 \
 typedef struct ds__##name##_node {\
     T data;\
@@ -125,15 +148,75 @@ typedef struct ds__##name##_node {\
 typedef struct {\
     ds_size count;\
     ds__##name##_node *root;\
+    ds__##name##_node *block;\
+    ds_size block_count;\
 } name;\
 \
+ds_DECLARE_SORT_NAMED(ds__##name##_sort, T, x_y_comparer)\
+\
 ds_API static inline name name##_new(void) {\
     return (name) {\
         0,\
         ds_NULL,\
+        ds_NULL,\
+        0,\
     };\
 }\
 \
+ds_API static inline ds__##name##_node *ds__##name##_build(ds__##name##_node *nodes, ds_size count) {\
+    if (count == 0) {\
+        return ds_NULL;\
+    }\
+    ds_size middle = count / 2;\
+    ds__##name##_node *node = nodes + middle;\
+    node->left = ds__##name##_build(nodes, middle);\
+    node->right = ds__##name##_build(node + 1, count - middle - 1);\
+    return node;\
+}\
+\
+ds_API static inline name name##_from_array(const T *data, ds_size count, ds_bool sorted) {\
+    ds_assert(count == 0 || data != ds_NULL);\
+    name self = name##_new();\
+    if (count == 0) {\
+        return self;\
+    }\
+    T *array = ds_NULL;\
+    if (!sorted) {\
+        array = (T *) ds_malloc(sizeof(T) * count * 2);\
+        ds_assert(array != ds_NULL);\
+        ds_memcpy(array, data, sizeof(T) * count);\
+        ds__##name##_sort(array, array + count, count);\
+        data = array;\
+    }\
+    ds__##name##_node *nodes = (ds__##name##_node *) ds_malloc(sizeof(ds__##name##_node) * count);\
+    ds_assert(nodes != ds_NULL);\
+    for (ds_size i = 0; i < count; ++i) {\
+        if (i + 1 < count) {\
+            T x = data[i];\
+            T y = data[i + 1];\
+            ds_assert(!(x_y_comparer));\
+            if ((x_y_equals)) {\
+                T duplicate = data[i];\
+                deleter(&duplicate);\
+                continue;\
+            }\
+        }\
+        nodes[self.count++].data = data[i];\
+    }\
+    ds_free(array);\
+    self.root = ds__##name##_build(nodes, self.count);\
+    self.block = nodes;\
+    self.block_count = self.count;\
+    return self;\
+}\
+\
+ds_API static inline void ds__##name##_free(name *self, ds__##name##_node *node) {\
+    ds_assert(self != ds_NULL && node != ds_NULL);\
+    if (self->block == ds_NULL || node < self->block || node >= self->block + self->block_count) {\
+        ds_free(node);\
+    }\
+}\
+\
 ds_API static inline ds_size name##_count(const name *self) {\
     ds_assert(self != ds_NULL);\
     return self->count;\
@@ -173,10 +256,11 @@ ds_API static inline const T *name##_find(const name *self, T data) {\
     while (current != ds_NULL) {\
         T x = data;\
         T y = current->data;\
-        if ((x_y_equals)) {\
+        ds_int order = (x_y_compare);\
+        if (order == 0) {\
             return &current->data;\
         }\
-        if ((x_y_comparer)) {\
+        if (order > 0) {\
             current = current->right;\
         } else {\
             current = current->left;\
@@ -206,12 +290,13 @@ ds_API static inline ds_bool name##_insert(name *self, T data) {\
     while (ds_true) {\
         T x = data;\
         T y = current->data;\
-        if ((x_y_equals)) {\
+        ds_int order = (x_y_compare);\
+        if (order == 0) {\
             deleter(&current->data);\
             current->data = data;\
             return ds_true;\
         }\
-        if ((x_y_comparer)) {\
+        if (order > 0) {\
             if (current->right == ds_NULL) {\
                 ++self->count;\
                 ds__##name##_node *node = (ds__##name##_node *) ds_calloc(1, sizeof(ds__##name##_node));\
@@ -249,10 +334,7 @@ ds_API static inline void ds__##name##_copy(name *self, const ds__##name##_node
 ds_API static inline name name##_copy(const name *set) {\
     ds_assert(set != ds_NULL);\
     ds_assert((set->root == ds_NULL) == (set->count == 0));\
-    name self = (name) {\
-        0,\
-        ds_NULL,\
-    };\
+    name self = name##_new();\
     if (set->root != ds_NULL) {\
         ds__##name##_copy(&self, set->root);\
     }\
@@ -272,7 +354,8 @@ ds_API static inline ds_bool name##_erase(name *self, T data) {\
     while (ds_true) {\
         T x = data;\
         T y = current->data;\
-        if ((x_y_equals)) {\
+        ds_int order = (x_y_compare);\
+        if (order == 0) {\
             --self->count;\
             ds__##name##_node *replace_parent = current;\
             ds__##name##_node *replace = current->left;\
@@ -303,11 +386,11 @@ ds_API static inline ds_bool name##_erase(name *self, T data) {\
                 }\
             }\
             deleter(&current->data);\
-            ds_free(current);\
+            ds__##name##_free(self, current);\
             return ds_true;\
         }\
         parent = current;\
-        if ((x_y_comparer)) {\
+        if (order > 0) {\
             if (current->right == ds_NULL) {\
                 return ds_false;\
             }\
@@ -410,16 +493,16 @@ ds_API static inline name *name##_difference(name *self, const name *set) {\
     return self;\
 }\
 \
-ds_API static inline void ds__##name##_clear(ds__##name##_node *node) {\
-    ds_assert(node != ds_NULL);\
+ds_API static inline void ds__##name##_clear(name *self, ds__##name##_node *node) {\
+    ds_assert(self != ds_NULL && node != ds_NULL);\
     if (node->left != ds_NULL) {\
-        ds__##name##_clear(node->left);\
+        ds__##name##_clear(self, node->left);\
     }\
     ds__##name##_node *right = node->right;\
     deleter(&node->data);\
-    ds_free(node);\
+    ds__##name##_free(self, node);\
     if (right != ds_NULL) {\
-        ds__##name##_clear(right);\
+        ds__##name##_clear(self, right);\
     }\
 }\
 \
@@ -427,10 +510,13 @@ ds_API static inline void name##_clear(name *self) {\
     ds_assert(self != ds_NULL);\
     ds_assert((self->root == ds_NULL) == (self->count == 0));\
     if (self->root != ds_NULL) {\
-        ds__##name##_clear(self->root);\
+        ds__##name##_clear(self, self->root);\
     }\
+    ds_free(self->block);\
     self->count = 0;\
     self->root = ds_NULL;\
+    self->block = ds_NULL;\
+    self->block_count = 0;\
 }\
 \
 ds_API static inline void ds__##name##_foreach(const ds__##name##_node *node, void(*action)(T)) {\
@@ -459,8 +545,21 @@ ds_API static inline void name##_delete(name *self) {\
     *self = (name) {0};\
 }
 
+/** Declares a named sorted binary tree set of the given type. */
+#define ds_DECLARE_SET_NAMED(name, T, x_y_comparer, x_y_equals, deleter)\
+        ds__DECLARE_SET_CORE(name, T, x_y_comparer, x_y_equals,\
+        (x_y_equals) ? 0 : (x_y_comparer) ? 1 : -1, deleter)
+
+/** Declares a named sorted binary tree set of the given type with a three-way comparison. */
+#define ds_DECLARE_SET3_NAMED(name, T, x_y_compare, deleter)\
+        ds__DECLARE_SET_CORE(name, T, (x_y_compare) > 0, (x_y_compare) == 0, x_y_compare, deleter)
+
 /** Declares a sorted binary tree set of the given type. */
 #define ds_DECLARE_SET(T, x_y_comparer, x_y_equals, deleter)\
         ds_DECLARE_SET_NAMED(T##_set, T, x_y_comparer, x_y_equals, deleter)
 
+/** Declares a sorted binary tree set of the given type with a three-way comparison. */
+#define ds_DECLARE_SET3(T, x_y_compare, deleter)\
+        ds_DECLARE_SET3_NAMED(T##_set, T, x_y_compare, deleter)
+
 #endif // DS_SET_H
@@ -0,0 +1,260 @@
+// .h
+// ds.h Small Inline Hash Map Data Structure
+// by Kyle Furey
+
+/**
+ * ds_smallmap.h
+ *
+ * ds_DECLARE_SMALLMAP_NAMED(
+ *      name,           - The name of the data structure and function prefix.
+ *
+ *      K,              - The key type used to index V.
+ *
+ *      V,              - The value type to generate this data structure with.
+ *
+ *      N,              - The number of pairs stored inline before the map switches to hashing.
+ *
+ *      key_hasher,     - Inline hashing code used to hash a key named <key>.
+ *                        You can use ds_DEFAULT_HASH, ds_INT_HASH, ds_STRING_HASH, or a custom hasher.
+ *                        ds_FAST_HASH and ds_FAST_STRING_HASH are faster for keys larger than a few bytes.
+ *
+ *      x_y_equals,     - Inline comparison code used to equate keys <x> and <y>.
+ *                        You can use ds_DEFAULT_EQUALS for trivial types.
+ *
+ *      value_deleter,  - The name of the function used to deallocate V.
+ *                        ds_void_deleter may be used for trivial types.
+ * )
+ *
+ * This is a key-value map for maps that usually hold only a few pairs.
+ * Up to N pairs are stored inline in flat arrays and found by comparing every key, so small maps never hash or allocate.
+ * Keys are stored apart from values so a scan only touches keys.
+ *
+ * Inserting pair N + 1 moves every pair into a ds_map.h map, which is used from then on.
+ * Clearing the map frees that map and returns to inline storage.
+ *
+ * * Returns a new empty small map. Nothing is allocated.
+ * * This data structure must be deleted with smallmap_delete().
+ *
+ *   smallmap     smallmap_new        ( void )
+ *
+ * * Returns a new small map copied from <map>.
+ * * The new map owns its own memory and must be deleted with smallmap_delete().
+ *
+ *   smallmap     smallmap_copy       ( const smallmap* map )
+ *
+ * * Returns the number of pairs in the map.
+ *
+ *   size_t       smallmap_count      ( const smallmap* self )
+ *
+ * * Returns whether the map is empty.
+ *
+ *   bool         smallmap_empty      ( const smallmap* self )
+ *
+ * * Returns whether the map has moved its pairs into a hash map.
+ *
+ *   bool         smallmap_spilled    ( const smallmap* self )
+ *
+ * * Returns a pointer to the value that matches <key>.
+ * * Returns NULL if no value matches.
+ *
+ *   V*           smallmap_find       ( smallmap* self, K key )
+ *
+ * * Returns a pointer to the value that matches <key>.
+ * * Returns NULL if no value matches.
+ *
+ *   const V*     smallmap_find_const ( const smallmap* self, K key )
+ *
+ * * Returns whether the map contains <key>.
+ *
+ *   bool         smallmap_contains   ( const smallmap* self, K key )
+ *
+ * * Inserts a new key-value pair into the map.
+ * * Returns whether a value was overwritten.
+ *
+ *   bool         smallmap_insert     ( smallmap* self, K key, V value )
+ *
+ * * Deletes the value that matches <key>.
+ * * Inline pairs after it may change order.
+ * * Returns whether <key> was found.
+ *
+ *   bool         smallmap_erase      ( smallmap* self, K key )
+ *
+ * * Deletes all pairs in the map and returns it to inline storage.
+ *
+ *   void         smallmap_clear      ( smallmap* self )
+ *
+ * * Iterates the map calling <action> on each key and value.
+ *
+ *   void         smallmap_foreach    ( const smallmap* self, void (*action)(K, V) )
+ *
+ * * Safely deletes a small map.
+ *
+ *   void         smallmap_delete     ( smallmap* self )
+ */
+
+#ifndef DS_SMALLMAP_H
+#define DS_SMALLMAP_H
+
+#include "ds_map.h"
+
+/** Declares a named small map of the given types that stores up to N pairs inline. */
+#define ds_DECLARE_SMALLMAP_NAMED(name, K, V, N, key_hasher, x_y_equals, value_deleter)\
+\
+ds_DECLARE_MAP_NAMED(ds__##name##_map, K, V, key_hasher, x_y_equals, value_deleter)\
+\
+typedef struct {\
+    ds_size count;\
+    K keys[N];\
+    V values[N];\
+    ds__##name##_map map;\
+} name;\
+\
+ds_API static inline ds_size ds__##name##_index(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->count <= N);\
+    for (ds_size i = 0; i < self->count; ++i) {\
+        K x = key;\
+        K y = self->keys[i];\
+        if ((x_y_equals)) {\
+            return i;\
+        }\
+    }\
+    return ds_NOT_FOUND;\
+}\
+\
+ds_API static inline void ds__##name##_spill(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->count == N);\
+    ds_assert(self->map.controls == ds_NULL);\
+    self->map = ds__##name##_map_new(N * 2);\
+    for (ds_size i = 0; i < N; ++i) {\
+        ds__##name##_map_insert(&self->map, self->keys[i], self->values[i]);\
+    }\
+    self->count = 0;\
+}\
+\
+ds_API static inline name name##_new(void) {\
+    ds_assert(N > 0);\
+    name self;\
+    self.count = 0;\
+    self.map = (ds__##name##_map) {0};\
+    return self;\
+}\
+\
+ds_API static inline name name##_copy(const name *map) {\
+    ds_assert(map != ds_NULL);\
+    name self = *map;\
+    if (map->map.controls != ds_NULL) {\
+        self.map = ds__##name##_map_copy(&map->map);\
+    }\
+    return self;\
+}\
+\
+ds_API static inline ds_bool name##_spilled(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->map.controls != ds_NULL;\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return name##_spilled(self) ? ds__##name##_map_count(&self->map) : self->count;\
+}\
+\
+ds_API static inline ds_bool name##_empty(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return name##_count(self) == 0;\
+}\
+\
+ds_API static inline V *name##_find(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    if (name##_spilled(self)) {\
+        return ds__##name##_map_find(&self->map, key);\
+    }\
+    ds_size index = ds__##name##_index(self, key);\
+    return index != ds_NOT_FOUND ? self->values + index : ds_NULL;\
+}\
+\
+ds_API static inline const V *name##_find_const(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    if (name##_spilled(self)) {\
+        return ds__##name##_map_find_const(&self->map, key);\
+    }\
+    ds_size index = ds__##name##_index(self, key);\
+    return index != ds_NOT_FOUND ? self->values + index : ds_NULL;\
+}\
+\
+ds_API static inline ds_bool name##_contains(const name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    return name##_find_const(self, key) != ds_NULL;\
+}\
+\
+ds_API static inline ds_bool name##_insert(name *self, K key, V value) {\
+    ds_assert(self != ds_NULL);\
+    if (!name##_spilled(self)) {\
+        ds_size index = ds__##name##_index(self, key);\
+        if (index != ds_NOT_FOUND) {\
+            value_deleter(self->values + index);\
+            self->values[index] = value;\
+            return ds_true;\
+        }\
+        if (self->count < N) {\
+            self->keys[self->count] = key;\
+            self->values[self->count] = value;\
+            ++self->count;\
+            return ds_false;\
+        }\
+        ds__##name##_spill(self);\
+    }\
+    return ds__##name##_map_insert(&self->map, key, value);\
+}\
+\
+ds_API static inline ds_bool name##_erase(name *self, K key) {\
+    ds_assert(self != ds_NULL);\
+    if (name##_spilled(self)) {\
+        return ds__##name##_map_erase(&self->map, key);\
+    }\
+    ds_size index = ds__##name##_index(self, key);\
+    if (index == ds_NOT_FOUND) {\
+        return ds_false;\
+    }\
+    value_deleter(self->values + index);\
+    --self->count;\
+    self->keys[index] = self->keys[self->count];\
+    self->values[index] = self->values[self->count];\
+    return ds_true;\
+}\
+\
+ds_API static inline void name##_clear(name *self) {\
+    ds_assert(self != ds_NULL);\
+    if (name##_spilled(self)) {\
+        ds__##name##_map_delete(&self->map);\
+    }\
+    for (ds_size i = 0; i < self->count; ++i) {\
+        value_deleter(self->values + i);\
+    }\
+    self->count = 0;\
+}\
+\
+ds_API static inline void name##_foreach(const name *self, void(*action)(K, V)) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(action != ds_NULL);\
+    if (name##_spilled(self)) {\
+        ds__##name##_map_foreach(&self->map, action);\
+        return;\
+    }\
+    for (ds_size i = 0; i < self->count; ++i) {\
+        action(self->keys[i], self->values[i]);\
+    }\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    name##_clear(self);\
+    *self = (name) {0};\
+}
+
+/** Declares a small map of the given types that stores up to N pairs inline. */
+#define ds_DECLARE_SMALLMAP(K, V, N, key_hasher, x_y_equals, value_deleter)\
+        ds_DECLARE_SMALLMAP_NAMED(K##_##V##_smallmap, K, V, N, key_hasher, x_y_equals, value_deleter)
+
+#endif // DS_SMALLMAP_H
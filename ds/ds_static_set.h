@@ -0,0 +1,306 @@
+// .h
+// ds.h Static Search Set Data Structure
+// by Kyle Furey
+
+/**
+ * ds_static_set.h
+ *
+ * ds_DECLARE_STATIC_SET_NAMED(
+ *      name,               - The name of the data structure and function prefix.
+ *
+ *      T,                  - The type to generate this data structure with.
+ *
+ *      x_y_comparer,       - Inline comparison code used to compare values <x> and <y>.
+ *                            You can use ds_DEFAULT_COMPARE for trivial types.
+ *
+ *      x_y_equals,         - Inline comparison code used to equate values <x> and <y>.
+ *                            You can use ds_DEFAULT_EQUALS for trivial types.
+ *
+ *      deleter,            - The name of the function used to deallocate T.
+ *                            ds_void_deleter may be used for trivial types.
+ * )
+ *
+ * This is an immutable sorted set built once and searched many times.
+ * Elements are stored in one cache-aligned array in Eytzinger (breadth-first) order.
+ * The root is at index 1 and the children of index k are at 2k and 2k + 1.
+ *
+ * Searching walks down the array without branching on comparisons.
+ * Descendants a few levels down share a cache line, so they are prefetched each step.
+ * Batched searches interleave many queries so their cache misses overlap.
+ *
+ * This is faster than binary trees and plain binary search for large read-mostly sets.
+ *
+ * * Returns a new static set of <count> elements in <data>.
+ * * <data> is sorted first unless <sorted> is true. Duplicates keep their last occurrence.
+ * * This data structure must be deleted with static_set_delete().
+ *
+ *   static_set       static_set_new          ( const T* data, size_t count, bool sorted )
+ *
+ * * Returns a new static set copied from <set>.
+ * * The new set owns its own memory and must be deleted with static_set_delete().
+ *
+ *   static_set       static_set_copy         ( const static_set* set )
+ *
+ * * Returns the number of elements in the set.
+ *
+ *   size_t           static_set_count        ( const static_set* self )
+ *
+ * * Returns whether the set is empty.
+ *
+ *   bool             static_set_empty        ( const static_set* self )
+ *
+ * * Returns a pointer to the least value in the set.
+ * * The set must not be empty.
+ *
+ *   const T*         static_set_least        ( const static_set* self )
+ *
+ * * Returns a pointer to the greatest value in the set.
+ * * The set must not be empty.
+ *
+ *   const T*         static_set_greatest     ( const static_set* self )
+ *
+ * * Returns a pointer to the least value in the set not less than <data>.
+ * * Returns NULL if every value is less than <data>.
+ *
+ *   const T*         static_set_lower_bound  ( const static_set* self, T data )
+ *
+ * * Returns a pointer to a value that matches <data> in the set.
+ * * Returns NULL if no value matches.
+ *
+ *   const T*         static_set_find         ( const static_set* self, T data )
+ *
+ * * Returns whether the set contains <data>.
+ *
+ *   bool             static_set_contains     ( const static_set* self, T data )
+ *
+ * * Searches for each of the <count> values in <data> with interleaved lookups.
+ * * Each result is set to a pointer to the matching value or NULL.
+ * * Returns the number of values found.
+ *
+ *   size_t           static_set_find_batch   ( const static_set* self, const T* data, size_t count, const T** results )
+ *
+ * * Iterates the set in-order calling <action> on each element.
+ *
+ *   void             static_set_foreach      ( const static_set* self, void (*action)(T) )
+ *
+ * * Safely deletes a static set.
+ *
+ *   void             static_set_delete       ( static_set* self )
+ */
+
+#ifndef DS_STATIC_SET_H
+#define DS_STATIC_SET_H
+
+#include "ds_def.h"
+
+/** The number of queries interleaved by a batched static set search. */
+#define ds_STATIC_SET_BATCH 16
+
+/** Declares a named static search set of the given type. */
+#define ds_DECLARE_STATIC_SET_NAMED(name, T, x_y_comparer, x_y_equals, deleter)\
+\
+typedef struct {\
+    ds_size count;\
+    T *array;\
+    void *block;\
+} name;\
+\
+enum {\
+    ds__##name##_PREFETCH = sizeof(T) < ds_CACHE_LINE ? ds_CACHE_LINE / sizeof(T) : 1,\
+};\
+\
+ds_DECLARE_SORT_NAMED(ds__##name##_sort, T, x_y_comparer)\
+\
+ds_API static inline name ds__##name##_alloc(ds_size count) {\
+    void *block = ds_malloc(sizeof(T) * (count + 1) + ds_CACHE_LINE);\
+    ds_assert(block != ds_NULL);\
+    ds_size address = ds_ARENA_ALIGN((ds_size) (uintptr_t) block, (ds_size) ds_CACHE_LINE);\
+    return (name) {\
+        count,\
+        (T *) ((ds_byte *) block + (address - (ds_size) (uintptr_t) block)),\
+        block,\
+    };\
+}\
+\
+ds_API static inline void ds__##name##_layout(T *array, ds_size count, const T *sorted, ds_size *index, ds_size k) {\
+    if (k > count) {\
+        return;\
+    }\
+    ds__##name##_layout(array, count, sorted, index, 2 * k);\
+    array[k] = sorted[(*index)++];\
+    ds__##name##_layout(array, count, sorted, index, 2 * k + 1);\
+}\
+\
+ds_API static inline name name##_new(const T *data, ds_size count, ds_bool sorted) {\
+    ds_assert(count == 0 || data != ds_NULL);\
+    T *array = (T *) ds_malloc(sizeof(T) * (count > 0 ? count * 2 : 1));\
+    ds_assert(array != ds_NULL);\
+    if (count > 0) {\
+        ds_memcpy(array, data, sizeof(T) * count);\
+    }\
+    if (!sorted) {\
+        ds__##name##_sort(array, array + count, count);\
+    }\
+    ds_size unique = 0;\
+    for (ds_size i = 0; i < count; ++i) {\
+        if (i + 1 < count) {\
+            T x = array[i];\
+            T y = array[i + 1];\
+            ds_assert(!(x_y_comparer));\
+            if ((x_y_equals)) {\
+                deleter(&array[i]);\
+                continue;\
+            }\
+        }\
+        array[unique++] = array[i];\
+    }\
+    name self = ds__##name##_alloc(unique);\
+    ds_size index = 0;\
+    ds__##name##_layout(self.array, unique, array, &index, 1);\
+    ds_assert(index == unique);\
+    ds_free(array);\
+    return self;\
+}\
+\
+ds_API static inline name name##_copy(const name *set) {\
+    ds_assert(set != ds_NULL);\
+    ds_assert(set->array != ds_NULL);\
+    name self = ds__##name##_alloc(set->count);\
+    ds_memcpy(self.array, set->array, sizeof(T) * (set->count + 1));\
+    return self;\
+}\
+\
+ds_API static inline ds_size name##_count(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->count;\
+}\
+\
+ds_API static inline ds_bool name##_empty(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    return self->count == 0;\
+}\
+\
+ds_API static inline const T *name##_least(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->count > 0);\
+    ds_size k = 1;\
+    while (2 * k <= self->count) {\
+        k = 2 * k;\
+    }\
+    return self->array + k;\
+}\
+\
+ds_API static inline const T *name##_greatest(const name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->count > 0);\
+    ds_size k = 1;\
+    while (2 * k + 1 <= self->count) {\
+        k = 2 * k + 1;\
+    }\
+    return self->array + k;\
+}\
+\
+ds_API static inline const T *name##_lower_bound(const name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->array != ds_NULL);\
+    const T *array = self->array;\
+    ds_size count = self->count;\
+    ds_size k = 1;\
+    while (k <= count) {\
+        ds_prefetch(array + k * ds__##name##_PREFETCH);\
+        T x = data;\
+        T y = array[k];\
+        k = 2 * k + ((x_y_comparer) ? 1 : 0);\
+    }\
+    k >>= ds_ctz(~k) + 1;\
+    return k != 0 ? array + k : ds_NULL;\
+}\
+\
+ds_API static inline const T *name##_find(const name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    const T *bound = name##_lower_bound(self, data);\
+    if (bound == ds_NULL) {\
+        return ds_NULL;\
+    }\
+    T x = data;\
+    T y = *bound;\
+    return (x_y_equals) ? bound : ds_NULL;\
+}\
+\
+ds_API static inline ds_bool name##_contains(const name *self, T data) {\
+    ds_assert(self != ds_NULL);\
+    return name##_find(self, data) != ds_NULL;\
+}\
+\
+ds_API static inline ds_size name##_find_batch(const name *self, const T *data, ds_size count, const T **results) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->array != ds_NULL);\
+    ds_assert(count == 0 || (data != ds_NULL && results != ds_NULL));\
+    const T *array = self->array;\
+    ds_size total = self->count;\
+    ds_size found = 0;\
+    for (ds_size start = 0; start < count; start += ds_STATIC_SET_BATCH) {\
+        ds_size batch = count - start < ds_STATIC_SET_BATCH ? count - start : ds_STATIC_SET_BATCH;\
+        ds_size k[ds_STATIC_SET_BATCH];\
+        for (ds_size i = 0; i < batch; ++i) {\
+            k[i] = 1;\
+        }\
+        for (ds_size level = 1; level <= total; level = 2 * level) {\
+            for (ds_size i = 0; i < batch; ++i) {\
+                if (k[i] <= total) {\
+                    ds_prefetch(array + k[i] * ds__##name##_PREFETCH);\
+                    T x = data[start + i];\
+                    T y = array[k[i]];\
+                    k[i] = 2 * k[i] + ((x_y_comparer) ? 1 : 0);\
+                }\
+            }\
+        }\
+        for (ds_size i = 0; i < batch; ++i) {\
+            ds_size index = k[i] >> (ds_ctz(~k[i]) + 1);\
+            results[start + i] = ds_NULL;\
+            if (index == 0) {\
+                continue;\
+            }\
+            T x = data[start + i];\
+            T y = array[index];\
+            if ((x_y_equals)) {\
+                results[start + i] = array + index;\
+                ++found;\
+            }\
+        }\
+    }\
+    return found;\
+}\
+\
+ds_API static inline void ds__##name##_foreach(const name *self, ds_size k, void(*action)(T)) {\
+    ds_assert(self != ds_NULL && action != ds_NULL);\
+    if (k > self->count) {\
+        return;\
+    }\
+    ds__##name##_foreach(self, 2 * k, action);\
+    action(self->array[k]);\
+    ds__##name##_foreach(self, 2 * k + 1, action);\
+}\
+\
+ds_API static inline void name##_foreach(const name *self, void(*action)(T)) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(action != ds_NULL);\
+    ds_assert(self->array != ds_NULL);\
+    ds__##name##_foreach(self, 1, action);\
+}\
+\
+ds_API static inline void name##_delete(name *self) {\
+    ds_assert(self != ds_NULL);\
+    ds_assert(self->array != ds_NULL);\
+    for (ds_size k = 1; k <= self->count; ++k) {\
+        deleter(&self->array[k]);\
+    }\
+    ds_free(self->block);\
+    *self = (name) {0};\
+}
+
+/** Declares a static search set of the given type. */
+#define ds_DECLARE_STATIC_SET(T, x_y_comparer, x_y_equals, deleter)\
+        ds_DECLARE_STATIC_SET_NAMED(T##_static_set, T, x_y_comparer, x_y_equals, deleter)
+
+#endif // DS_STATIC_SET_H
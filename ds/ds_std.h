@@ -21,6 +21,9 @@
  * stdio.h      - fprintf() and stderr for ds_assert()
  * assert.h     - assert()
  * math.h       - math functions
+ * emmintrin.h  - SSE2 intrinsics for probing maps, only when SSE2 is available
+ *
+ * ds_SSE2 is whether SSE2 intrinsics are available and included.
  *
  * ds_def.h can be modified to reduce or eliminate standard library dependency.
  */
@@ -38,4 +41,11 @@
 #include <assert.h>
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define ds_SSE2 1
+#include <emmintrin.h>
+#else
+#define ds_SSE2 0
+#endif
+
 #endif // DS_STD_H